@@ -162,7 +162,7 @@ def flipMesh(*args):
 
     with undoChunk():
         for mesh in selectedMeshes:
-            cmds.polyFlip(mesh, objectSpace=True)
+            cmds.polyFlip(mesh, worldSpace=True)
 
 
 def mirrorMesh(*args):
@@ -195,6 +195,40 @@ def mirrorMesh(*args):
             cmds.polyMirror(baseMesh, mesh)
 
 
+def mirrorBlendShapeTargets(blendShape, targets=None, targetPairs=None):
+    """Mirrors the targets of a blendShape node in one undoable step.
+
+    Parameters
+    ----------
+    blendShape : str
+        A blendShape node that deforms a mesh with poly symmetry data.
+    targets : list of int
+        Indices of the targets to mirror in place. If neither targets nor
+        targetPairs is given, every target is mirrored in place.
+    targetPairs : list of (int, int)
+        Source and destination target indices. Each destination is replaced
+        by the mirrored source, as for a left and right pair.
+
+    Raises
+    ------
+    RuntimeError
+        If the deformed mesh does not have poly symmetry data computed, or a
+        target index does not exist.
+
+    """
+
+    kwargs = {'blendShape': blendShape}
+
+    if targets:
+        kwargs['target'] = list(targets)
+
+    if targetPairs:
+        kwargs['targetPair'] = [tuple(pair) for pair in targetPairs]
+
+    # Pass the blendShape as the object so the active selection is not used.
+    cmds.polyMirror(blendShape, **kwargs)
+
+
 def copyPolySkinWeights(*args):
     """Copies the skinCluster weights from one mesh to another.
     
@@ -0,0 +1,148 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "bitArray.h"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+static int countBits(uint64_t word)
+{
+#if defined(_MSC_VER)
+    int result = 0;
+
+    for (; word != 0; word &= word - 1) { result++; }
+
+    return result;
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+static int lowestBit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    int result = 0;
+
+    for (; (word & 1) == 0; word >>= 1) { result++; }
+
+    return result;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+void BitArray::clear()
+{
+    words.clear();
+    numberOfBits = 0;
+}
+
+/*
+    Unlike vector::resize, every flag is set to value, not just the new ones.
+*/
+void BitArray::resize(int numberOfBits, bool value)
+{
+    this->numberOfBits = numberOfBits;
+
+    words.assign((numberOfBits + 63) / 64, value ? ~uint64_t(0) : 0);
+}
+
+void BitArray::fill(bool value)
+{
+    this->resize(numberOfBits, value);
+}
+
+/*
+    Sets flag i and returns whether it was already set, like testAndSet, but 
+    atomically, so threads can claim flags in the same array at the same time.
+*/
+bool BitArray::testAndSetAtomic(int i)
+{
+    uint64_t mask = uint64_t(1) << (i & 63);
+
+    // Most flags tested are already set, and a plain read is much cheaper than a locked write.
+#if defined(_MSC_VER)
+    if (*((volatile uint64_t*) &words[i >> 6]) & mask) { return true; }
+
+    uint64_t word = (uint64_t) _InterlockedOr64((volatile long long*) &words[i >> 6], (long long) mask);
+#else
+    if (__atomic_load_n(&words[i >> 6], __ATOMIC_RELAXED) & mask) { return true; }
+
+    uint64_t word = __atomic_fetch_or(&words[i >> 6], mask, __ATOMIC_RELAXED);
+#endif
+
+    return (word & mask) != 0;
+}
+
+/*
+    Sets every flag that is set in other, which must be the same size.
+*/
+void BitArray::merge(const BitArray &other)
+{
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        words[i] |= other.words[i];
+    }
+}
+
+int BitArray::count() const
+{
+    int result = 0;
+
+    for (int i = 0; i < numberOfBits; i += 64)
+    {
+        uint64_t word = words[i >> 6];
+
+        if (numberOfBits - i < 64)
+        {
+            word &= (uint64_t(1) << (numberOfBits - i)) - 1;
+        }
+
+        result += countBits(word);
+    }
+
+    return result;
+}
+
+/*
+    Returns the index of the first unset flag at or after from, 
+    or -1 if every flag from there on is set.
+*/
+int BitArray::findNextUnset(int from) const
+{
+    if (from < 0) { from = 0; }
+
+    int numberOfWords = (int) words.size();
+
+    for (int w = from >> 6; w < numberOfWords; w++)
+    {
+        uint64_t unsetBits = ~words[w];
+
+        if (w == (from >> 6))
+        {
+            unsetBits &= ~uint64_t(0) << (from & 63);
+        }
+
+        if (unsetBits != 0)
+        {
+            int result = (w << 6) + lowestBit(unsetBits);
+            return result < numberOfBits ? result : -1;
+        }
+    }
+
+    return -1;
+}
+
+size_t BitArray::memoryUsage() const
+{
+    return words.capacity() * sizeof(uint64_t);
+}
\ No newline at end of file
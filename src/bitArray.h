@@ -0,0 +1,47 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_BIT_ARRAY_H
+#define POLY_SYMMETRY_BIT_ARRAY_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/*
+    Dense array of flags, one per component, packed 64 to a word so that a 
+    flag for every component of a large mesh stays in cache. Unlike 
+    vector<bool>, unset flags can be found a word at a time.
+*/
+class BitArray
+{
+public:
+    void                clear();
+    void                resize(int numberOfBits, bool value=false);
+    void                fill(bool value);
+
+    int                 size() const                        { return numberOfBits; }
+    bool                operator[](int i) const             { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    void                set(int i)                          { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void                unset(int i)                        { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    bool                testAndSet(int i)                   { bool result = (*this)[i]; this->set(i); return result; }
+    bool                testAndSetAtomic(int i);
+
+    void                merge(const BitArray &other);
+
+    int                 count() const;
+    int                 findNextUnset(int from=0) const;
+
+    size_t              memoryUsage() const;
+
+private:
+    vector<uint64_t>    words;
+    int                 numberOfBits = 0;
+};
+
+#endif
\ No newline at end of file
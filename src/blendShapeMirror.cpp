@@ -0,0 +1,274 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "blendShapeMirror.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <maya/MDGModifier.h>
+#include <maya/MFnComponentListData.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFnPointArrayData.h>
+#include <maya/MFnSingleIndexedComponent.h>
+#include <maya/MIntArray.h>
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MPointArray.h>
+#include <maya/MStatus.h>
+
+using namespace std;
+
+static MPlug getItemChild(const MPlug &item, const char* attributeName)
+{
+    MFnDependencyNode fnNode(item.node());
+    return item.child(fnNode.attribute(attributeName));
+}
+
+/*
+    Reads the deltas of an inputTargetItem. An item without point data has
+    no deltas. Fails if the components and points do not match.
+*/
+MStatus BlendShapeMirror::readDeltas(const MPlug &item, SparseDeltas &deltas)
+{
+    deltas.indices.clear();
+    deltas.offsets.clear();
+
+    MObject pointsData;
+    MObject componentsData;
+
+    getItemChild(item, "inputPointsTarget").getValue(pointsData);
+    getItemChild(item, "inputComponentsTarget").getValue(componentsData);
+
+    if (pointsData.isNull() || componentsData.isNull()) { return MStatus::kSuccess; }
+
+    MFnPointArrayData fnPoints(pointsData);
+    MPointArray points = fnPoints.array();
+
+    MFnComponentListData fnComponents(componentsData);
+
+    for (unsigned c = 0; c < fnComponents.length(); c++)
+    {
+        MObject component = fnComponents[c];
+
+        if (!component.hasFn(MFn::kMeshVertComponent)) { continue; }
+
+        MFnSingleIndexedComponent fnComponent(component);
+
+        if (fnComponent.isComplete())
+        {
+            int numberOfElements = 0;
+            fnComponent.getCompleteData(numberOfElements);
+
+            for (int i = 0; i < numberOfElements; i++)
+            {
+                deltas.indices.push_back(i);
+            }
+        } else {
+            MIntArray elements;
+            fnComponent.getElements(elements);
+
+            for (unsigned i = 0; i < elements.length(); i++)
+            {
+                deltas.indices.push_back(elements[i]);
+            }
+        }
+    }
+
+    if (deltas.indices.size() != points.length())
+    {
+        deltas.indices.clear();
+        return MStatus::kFailure;
+    }
+
+    deltas.offsets.resize(3 * points.length());
+
+    for (unsigned i = 0; i < points.length(); i++)
+    {
+        deltas.offsets[3 * i + 0] = points[i].x;
+        deltas.offsets[3 * i + 1] = points[i].y;
+        deltas.offsets[3 * i + 2] = points[i].z;
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Adds the new point and component data of an inputTargetItem to the
+    modifier, so that a batch of targets is undone in one step.
+*/
+MStatus BlendShapeMirror::writeDeltas(const MPlug &item, const SparseDeltas &deltas, MDGModifier &dgModifier)
+{
+    MStatus status;
+
+    unsigned numberOfDeltas = (unsigned) deltas.indices.size();
+
+    MPointArray points(numberOfDeltas);
+    MIntArray elements(numberOfDeltas);
+
+    for (unsigned i = 0; i < numberOfDeltas; i++)
+    {
+        points.set(i, deltas.offsets[3 * i + 0], deltas.offsets[3 * i + 1], deltas.offsets[3 * i + 2]);
+        elements[i] = deltas.indices[i];
+    }
+
+    MFnSingleIndexedComponent fnComponent;
+    MObject component = fnComponent.create(MFn::kMeshVertComponent, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    fnComponent.addElements(elements);
+
+    MFnComponentListData fnComponents;
+    MObject componentsData = fnComponents.create(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    fnComponents.add(component);
+
+    MFnPointArrayData fnPoints;
+    MObject pointsData = fnPoints.create(points, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = dgModifier.newPlugValue(getItemChild(item, "inputPointsTarget"), pointsData);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = dgModifier.newPlugValue(getItemChild(item, "inputComponentsTarget"), componentsData);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Returns true if a mesh drives the item. Its deltas would be replaced
+    by the mesh on the next evaluation.
+*/
+bool BlendShapeMirror::hasTargetGeometry(const MPlug &item)
+{
+    return getItemChild(item, "inputGeomTarget").isConnected();
+}
+
+/*
+    Mirrors every job, in parallel across jobs. Each thread keeps a vertex
+    lookup for the whole mesh, which is cleared after every job.
+*/
+void BlendShapeMirror::mirrorDeltas(
+    vector<BlendShapeMirrorJob> &jobs,
+    const int* vertexSymmetry,
+    int numberOfVertices,
+    const float matrix[3][4]
+) {
+    vector<vector<int>> threadSlots(ThreadPool::numberOfThreads());
+
+    ThreadPool::parallelFor(
+        (int) jobs.size(),
+        [&](int taskIndex, int threadIndex)
+        {
+            vector<int> &slots = threadSlots[threadIndex];
+
+            if (slots.empty()) { slots.resize(numberOfVertices, -1); }
+
+            BlendShapeMirrorJob &job = jobs[taskIndex];
+
+            BlendShapeMirror::mirrorDeltas(
+                job.source,
+                job.result,
+                job.flip,
+                vertexSymmetry,
+                numberOfVertices,
+                matrix,
+                slots
+            );
+        }
+    );
+}
+
+/*
+    For each vertex i, with o = vertexSymmetry[i] and M the linear part of
+    the reflection:
+
+        result[i] = M * source[o]               if flip
+        result[i] = source[i] + M * source[o]   otherwise
+
+    slots must hold -1 for every vertex, and is left that way.
+*/
+void BlendShapeMirror::mirrorDeltas(
+    const SparseDeltas &source,
+    SparseDeltas &result,
+    bool flip,
+    const int* vertexSymmetry,
+    int numberOfVertices,
+    const float matrix[3][4],
+    vector<int> &slots
+) {
+    result.indices.clear();
+    result.offsets.clear();
+
+    int numberOfDeltas = (int) source.indices.size();
+
+    vector<int> vertices;
+    vertices.reserve(2 * numberOfDeltas);
+
+    for (int k = 0; k < numberOfDeltas; k++)
+    {
+        int i = source.indices[k];
+
+        if ((unsigned) i >= (unsigned) numberOfVertices) { continue; }
+
+        int o = vertexSymmetry[i];
+
+        slots[i] = k;
+
+        if (!flip) { vertices.push_back(i); }
+        vertices.push_back((unsigned) o < (unsigned) numberOfVertices ? o : i);
+    }
+
+    sort(vertices.begin(), vertices.end());
+    vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+
+    result.indices.reserve(vertices.size());
+    result.offsets.reserve(3 * vertices.size());
+
+    for (int i : vertices)
+    {
+        int o = vertexSymmetry[i];
+
+        if ((unsigned) o >= (unsigned) numberOfVertices) { o = i; }
+
+        double offset[3] = {0.0, 0.0, 0.0};
+
+        if (!flip && slots[i] != -1)
+        {
+            const double* d = source.offsets.data() + 3 * slots[i];
+
+            offset[0] = d[0];
+            offset[1] = d[1];
+            offset[2] = d[2];
+        }
+
+        if (slots[o] != -1)
+        {
+            const double* d = source.offsets.data() + 3 * slots[o];
+
+            for (int r = 0; r < 3; r++)
+            {
+                offset[r] += matrix[r][0] * d[0] + matrix[r][1] * d[1] + matrix[r][2] * d[2];
+            }
+        }
+
+        if (offset[0] == 0.0 && offset[1] == 0.0 && offset[2] == 0.0) { continue; }
+
+        result.indices.push_back(i);
+        result.offsets.push_back(offset[0]);
+        result.offsets.push_back(offset[1]);
+        result.offsets.push_back(offset[2]);
+    }
+
+    for (int k = 0; k < numberOfDeltas; k++)
+    {
+        int i = source.indices[k];
+
+        if ((unsigned) i < (unsigned) numberOfVertices) { slots[i] = -1; }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_BLEND_SHAPE_MIRROR_H
+#define POLY_SYMMETRY_BLEND_SHAPE_MIRROR_H
+
+#include <vector>
+
+#include <maya/MDGModifier.h>
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MStatus.h>
+
+using namespace std;
+
+/*
+    The deltas of a blendShape inputTargetItem - the vertices in its
+    inputComponentsTarget and the matching offsets in its inputPointsTarget,
+    three doubles per vertex.
+*/
+struct SparseDeltas
+{
+    vector<int>         indices;
+    vector<double>      offsets;
+};
+
+/*
+    One inputTargetItem to mirror. If flip is true the result is only the
+    mirrored source - the other side of an L/R pair. Otherwise the result is
+    the source plus its mirror, like polyMirror on a mesh.
+*/
+struct BlendShapeMirrorJob
+{
+    MPlug               sourceItem;
+    MPlug               destinationItem;
+    bool                flip = false;
+
+    SparseDeltas        source;
+    SparseDeltas        result;
+};
+
+/*
+    Mirrors blendShape targets without going through a mesh. The deltas are
+    read and written on the main thread, and mirrored in parallel across
+    targets. Only the vertices with a delta on either side are touched, so
+    the cost is in the size of the targets, not of the mesh.
+*/
+class BlendShapeMirror
+{
+public:
+    static MStatus      readDeltas(const MPlug &item, SparseDeltas &deltas);
+    static MStatus      writeDeltas(const MPlug &item, const SparseDeltas &deltas, MDGModifier &dgModifier);
+
+    static bool         hasTargetGeometry(const MPlug &item);
+
+    static void         mirrorDeltas(
+                            vector<BlendShapeMirrorJob> &jobs,
+                            const int* vertexSymmetry,
+                            int numberOfVertices,
+                            const float matrix[3][4]
+                        );
+
+    static void         mirrorDeltas(
+                            const SparseDeltas &source,
+                            SparseDeltas &result,
+                            bool flip,
+                            const int* vertexSymmetry,
+                            int numberOfVertices,
+                            const float matrix[3][4],
+                            vector<int> &slots
+                        );
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,369 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "diskCache.h"
+#include "polySymmetry.h"
+#include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <maya/MGlobal.h>
+#include <maya/MObject.h>
+#include <maya/MStatus.h>
+
+using namespace std;
+
+static const char DISK_CACHE_MAGIC[4] = {'P', 'S', 'Y', 'M'};
+
+static size_t getCacheFileSize(const SymmetryCacheHeader &header)
+{
+    size_t numberOfComponents = (size_t) header.numberOfEdges + (size_t) header.numberOfFaces + (size_t) header.numberOfVertices;
+
+    return sizeof(SymmetryCacheHeader) + numberOfComponents * (sizeof(int32_t) + sizeof(int8_t));
+}
+
+SymmetryCacheFile::~SymmetryCacheFile()
+{
+    this->close();
+}
+
+/*
+    Maps the file and checks that its header and size agree.
+    Returns false if the file is missing or malformed.
+*/
+bool SymmetryCacheFile::open(const string &path)
+{
+    this->close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG) sizeof(SymmetryCacheHeader))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+
+    if (fileMapping == NULL) { return false; }
+
+    void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(fileMapping);
+
+    if (view == NULL) { return false; }
+
+    this->mapping = view;
+    this->mappingSize = (size_t) fileSize.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd == -1) { return false; }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t) sizeof(SymmetryCacheHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (view == MAP_FAILED) { return false; }
+
+    this->mapping = view;
+    this->mappingSize = (size_t) fileStat.st_size;
+#endif
+
+    const SymmetryCacheHeader* fileHeader = (const SymmetryCacheHeader*) this->mapping;
+
+    bool isValid = memcmp(fileHeader->magic, DISK_CACHE_MAGIC, 4) == 0
+        && fileHeader->formatVersion == DISK_CACHE_FORMAT_VERSION
+        && fileHeader->numberOfEdges >= 0
+        && fileHeader->numberOfFaces >= 0
+        && fileHeader->numberOfVertices >= 0
+        && getCacheFileSize(*fileHeader) == this->mappingSize;
+
+    if (!isValid)
+    {
+        this->close();
+        return false;
+    }
+
+    const char* data = (const char*) this->mapping + sizeof(SymmetryCacheHeader);
+
+    this->header = fileHeader;
+
+    this->edgeSymmetry = (const int32_t*) data;
+    this->faceSymmetry = this->edgeSymmetry + fileHeader->numberOfEdges;
+    this->vertexSymmetry = this->faceSymmetry + fileHeader->numberOfFaces;
+
+    this->edgeSides = (const int8_t*) (this->vertexSymmetry + fileHeader->numberOfVertices);
+    this->faceSides = this->edgeSides + fileHeader->numberOfEdges;
+    this->vertexSides = this->faceSides + fileHeader->numberOfFaces;
+
+    return true;
+}
+
+void SymmetryCacheFile::close()
+{
+    if (this->mapping != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(this->mapping);
+#else
+        munmap(this->mapping, this->mappingSize);
+#endif
+    }
+
+    this->mapping = nullptr;
+    this->mappingSize = 0;
+
+    this->header = nullptr;
+
+    this->edgeSymmetry = nullptr;
+    this->faceSymmetry = nullptr;
+    this->vertexSymmetry = nullptr;
+
+    this->edgeSides = nullptr;
+    this->faceSides = nullptr;
+    this->vertexSides = nullptr;
+}
+
+bool SymmetryCacheFile::matches(const PolySymmetryCacheKey &key) const
+{
+    return this->header != nullptr
+        && this->header->numberOfEdges == key.numberOfEdges
+        && this->header->numberOfFaces == key.numberOfFaces
+        && this->header->numberOfVertices == key.numberOfVertices
+        && this->header->checksumVersion == key.checksumVersion
+        && this->header->vertexChecksum == key.vertexChecksum;
+}
+
+/*
+    A symmetry table is valid if every index is in range and every component
+    is the mirror of its mirror. A file that was damaged after it was written
+    fails this and is treated as a miss.
+*/
+static bool isValidSymmetry(const int32_t* symmetry, int numberOfComponents)
+{
+    for (int i = 0; i < numberOfComponents; i++)
+    {
+        int32_t s = symmetry[i];
+
+        if (s < 0 || s >= numberOfComponents || symmetry[s] != i)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SymmetryCacheFile::isValid() const
+{
+    return this->header != nullptr
+        && isValidSymmetry(this->edgeSymmetry, this->header->numberOfEdges)
+        && isValidSymmetry(this->faceSymmetry, this->header->numberOfFaces)
+        && isValidSymmetry(this->vertexSymmetry, this->header->numberOfVertices);
+}
+
+string PolySymmetryDiskCache::getCacheDirectory()
+{
+    const char* directory = getenv(DISK_CACHE_ENVIRONMENT_VARIABLE);
+
+    return directory == nullptr ? string() : string(directory);
+}
+
+bool PolySymmetryDiskCache::isEnabled()
+{
+    return !PolySymmetryDiskCache::getCacheDirectory().empty();
+}
+
+string PolySymmetryDiskCache::getCachePath(const PolySymmetryCacheKey &key)
+{
+    char fileName[96];
+
+    snprintf(
+        fileName,
+        sizeof(fileName),
+        "%d_%d_%d_%016llx.psym",
+        key.numberOfEdges,
+        key.numberOfFaces,
+        key.numberOfVertices,
+        (unsigned long long) key.vertexChecksum
+    );
+
+    return PolySymmetryDiskCache::getCacheDirectory() + "/" + fileName;
+}
+
+bool PolySymmetryDiskCache::read(const PolySymmetryCacheKey &key, SymmetryCacheFile &file)
+{
+    if (key.empty() || key.checksumVersion != kTopologyChecksum || !PolySymmetryDiskCache::isEnabled())
+    {
+        return false;
+    }
+
+    if (!file.open(PolySymmetryDiskCache::getCachePath(key)))
+    {
+        return false;
+    }
+
+    if (!file.matches(key) || !file.isValid())
+    {
+        file.close();
+        return false;
+    }
+
+    return true;
+}
+
+static bool isResolved(const vector<int> &symmetry)
+{
+    return all_of(symmetry.begin(), symmetry.end(), [](int i) { return i >= 0; });
+}
+
+/*
+    Saves the tables of a mesh, replacing any saved ones, since this runs
+    after an explicit solve. Tables with unresolved (-1) components are not
+    saved. The file is written next to its final path and renamed into place.
+*/
+MStatus PolySymmetryDiskCache::write(const PolySymmetryCacheKey &key, const PolySymmetryData &data)
+{
+    if (key.empty() || key.checksumVersion != kTopologyChecksum || !PolySymmetryDiskCache::isEnabled())
+    {
+        return MStatus::kSuccess;
+    }
+
+    bool hasValidTables = (int) data.edgeSymmetryIndices.size() == key.numberOfEdges
+        && (int) data.faceSymmetryIndices.size() == key.numberOfFaces
+        && (int) data.vertexSymmetryIndices.size() == key.numberOfVertices
+        && (int) data.edgeSides.size() == key.numberOfEdges
+        && (int) data.faceSides.size() == key.numberOfFaces
+        && (int) data.vertexSides.size() == key.numberOfVertices;
+
+    hasValidTables = hasValidTables
+        && isResolved(data.edgeSymmetryIndices)
+        && isResolved(data.faceSymmetryIndices)
+        && isResolved(data.vertexSymmetryIndices);
+
+    if (!hasValidTables) { return MStatus::kInvalidParameter; }
+
+    string directory = PolySymmetryDiskCache::getCacheDirectory();
+    string path = PolySymmetryDiskCache::getCachePath(key);
+
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+
+    string temporaryPath = path + "." + to_string(_getpid()) + ".tmp";
+#else
+    mkdir(directory.c_str(), 0777);
+
+    string temporaryPath = path + "." + to_string(getpid()) + ".tmp";
+#endif
+
+    SymmetryCacheHeader header;
+
+    memcpy(header.magic, DISK_CACHE_MAGIC, 4);
+    header.formatVersion = DISK_CACHE_FORMAT_VERSION;
+    header.numberOfEdges = key.numberOfEdges;
+    header.numberOfFaces = key.numberOfFaces;
+    header.numberOfVertices = key.numberOfVertices;
+    header.checksumVersion = key.checksumVersion;
+    header.vertexChecksum = key.vertexChecksum;
+
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+
+    bool written = file != nullptr;
+
+    written = written && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(data.edgeSymmetryIndices.data(), sizeof(int32_t), data.edgeSymmetryIndices.size(), file) == data.edgeSymmetryIndices.size()
+        && fwrite(data.faceSymmetryIndices.data(), sizeof(int32_t), data.faceSymmetryIndices.size(), file) == data.faceSymmetryIndices.size()
+        && fwrite(data.vertexSymmetryIndices.data(), sizeof(int32_t), data.vertexSymmetryIndices.size(), file) == data.vertexSymmetryIndices.size()
+        && fwrite(data.edgeSides.data(), sizeof(int8_t), data.edgeSides.size(), file) == data.edgeSides.size()
+        && fwrite(data.faceSides.data(), sizeof(int8_t), data.faceSides.size(), file) == data.faceSides.size()
+        && fwrite(data.vertexSides.data(), sizeof(int8_t), data.vertexSides.size(), file) == data.vertexSides.size();
+
+    if (file != nullptr)
+    {
+        written = (fclose(file) == 0) && written;
+    }
+
+#ifdef _WIN32
+    written = written && MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    written = written && rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+
+    if (!written)
+    {
+        remove(temporaryPath.c_str());
+
+        MString warningMsg("polySymmetry: cannot write to the symmetry cache at ^1s.");
+        warningMsg.format(warningMsg, MString(directory.c_str()));
+
+        MGlobal::displayWarning(warningMsg);
+        return MStatus::kFailure;
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Copies the tables in a disk cache file into new tables data, which is 
+    not set on any node.
+*/
+MStatus PolySymmetryDiskCache::createTables(const PolySymmetryCacheKey &key, const SymmetryCacheFile &file, MObject &tablesData, const PolySymmetryTables* &tables)
+{
+    MStatus status;
+
+    PolySymmetryTables* newTables;
+
+    status = PolySymmetryNode::newTables(tablesData, newTables);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    newTables->setTables(
+        key.numberOfEdges,
+        key.numberOfFaces,
+        key.numberOfVertices,
+        file.edgeSymmetry,
+        file.faceSymmetry,
+        file.vertexSymmetry,
+        file.edgeSides,
+        file.faceSides,
+        file.vertexSides
+    );
+
+    tables = newTables;
+
+    return MStatus::kSuccess;
+}
\ No newline at end of file
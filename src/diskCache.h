@@ -0,0 +1,102 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_DISK_CACHE_H
+#define POLY_SYMMETRY_DISK_CACHE_H
+
+#include "polySymmetry.h"
+#include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
+
+#include <cstdint>
+#include <string>
+
+#include <maya/MObject.h>
+#include <maya/MStatus.h>
+
+#define DISK_CACHE_ENVIRONMENT_VARIABLE "POLY_SYMMETRY_CACHE_DIR"
+
+#define DISK_CACHE_FORMAT_VERSION 1
+
+using namespace std;
+
+/*
+    The header of a disk cache file. It is followed by the edge, face and
+    vertex symmetry as int32, then the edge, face and vertex sides as int8.
+*/
+struct SymmetryCacheHeader
+{
+    char            magic[4];
+    uint32_t        formatVersion;
+    int32_t         numberOfEdges;
+    int32_t         numberOfFaces;
+    int32_t         numberOfVertices;
+    int32_t         checksumVersion;
+    uint64_t        vertexChecksum;
+};
+
+/*
+    A disk cache file mapped into memory. The tables point into the mapping,
+    so they are only valid until the file is closed.
+*/
+class SymmetryCacheFile
+{
+public:
+                        SymmetryCacheFile() {}
+                        ~SymmetryCacheFile();
+
+    bool                open(const string &path);
+    void                close();
+
+    bool                matches(const PolySymmetryCacheKey &key) const;
+    bool                isValid() const;
+
+public:
+    const SymmetryCacheHeader*  header = nullptr;
+
+    const int32_t*      edgeSymmetry = nullptr;
+    const int32_t*      faceSymmetry = nullptr;
+    const int32_t*      vertexSymmetry = nullptr;
+
+    const int8_t*       edgeSides = nullptr;
+    const int8_t*       faceSides = nullptr;
+    const int8_t*       vertexSides = nullptr;
+
+private:
+    void*               mapping = nullptr;
+    size_t              mappingSize = 0;
+};
+
+/*
+    Symmetry tables saved to a local directory, so that a mesh whose
+    polySymmetryData node is not in the scene does not have to be solved
+    again. Files are named by the cache key of the mesh. Only keys with a 
+    kTopologyChecksum are stored, since a 64-bit checksum identifies the mesh.
+
+    The cache is enabled by setting POLY_SYMMETRY_CACHE_DIR. Files are written
+    under a temporary name and renamed into place, so sessions that share
+    the directory never read a partial file.
+*/
+class PolySymmetryDiskCache
+{
+public:
+    static bool         isEnabled();
+    static string       getCachePath(const PolySymmetryCacheKey &key);
+
+    static bool         read(const PolySymmetryCacheKey &key, SymmetryCacheFile &file);
+    static MStatus      write(const PolySymmetryCacheKey &key, const PolySymmetryData &data);
+
+    static MStatus      createTables(
+                            const PolySymmetryCacheKey &key, 
+                            const SymmetryCacheFile &file, 
+                            MObject &tablesData, 
+                            const PolySymmetryTables* &tables
+                        );
+
+private:
+    static string       getCacheDirectory();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "halfEdgeMesh.h"
+#include "meshData.h"
+
+#include <vector>
+
+using namespace std;
+
+void HalfEdgeMesh::clear()
+{
+    origin.clear();
+    next.clear();
+    prev.clear();
+    twin.clear();
+    edge.clear();
+    face.clear();
+    faceHalfEdges.clear();
+}
+
+void HalfEdgeMesh::build(const MeshData &meshData)
+{
+    this->clear();
+
+    int numberOfHalfEdges = (int) meshData.faceCorners.indices.size();
+
+    origin = meshData.faceCorners.indices;
+    faceHalfEdges = meshData.faceCorners.offsets;
+
+    next.resize(numberOfHalfEdges);
+    prev.resize(numberOfHalfEdges);
+    twin.resize(numberOfHalfEdges, -1);
+    face.resize(numberOfHalfEdges);
+
+    for (int f = 0; f < meshData.numberOfFaces; f++)
+    {
+        int first = faceHalfEdges[f];
+        int last = faceHalfEdges[f + 1];
+
+        for (int h = first; h < last; h++)
+        {
+            next[h] = h + 1 < last ? h + 1 : first;
+            prev[h] = h > first ? h - 1 : last - 1;
+            face[h] = f;
+        }
+    }
+
+    edge = meshData.faceCornerEdges;
+
+    vector<int> firstHalfEdges(meshData.numberOfEdges, -1);
+    vector<int> lastHalfEdges(meshData.numberOfEdges, -1);
+
+    for (int h = 0; h < numberOfHalfEdges; h++)
+    {
+        int e = edge[h];
+
+        if (e == -1) { continue; }
+
+        if (firstHalfEdges[e] == -1)
+        {
+            firstHalfEdges[e] = h;
+        } else {
+            twin[lastHalfEdges[e]] = h;
+        }
+
+        lastHalfEdges[e] = h;
+    }
+
+    // Close the cycle of each edge with more than one face.
+    for (int e = 0; e < meshData.numberOfEdges; e++)
+    {
+        if (firstHalfEdges[e] != lastHalfEdges[e])
+        {
+            twin[lastHalfEdges[e]] = firstHalfEdges[e];
+        }
+    }
+}
+
+int HalfEdgeMesh::findHalfEdge(int faceIndex, int edgeIndex) const
+{
+    for (int h = faceHalfEdges[faceIndex]; h < faceHalfEdges[faceIndex + 1]; h++)
+    {
+        if (edge[h] == edgeIndex) 
+        { 
+            return h; 
+        }
+    }
+
+    return -1;
+}
+
+size_t HalfEdgeMesh::memoryUsage() const
+{
+    return (
+        origin.capacity() 
+        + next.capacity() 
+        + prev.capacity() 
+        + twin.capacity() 
+        + edge.capacity() 
+        + face.capacity() 
+        + faceHalfEdges.capacity()
+    ) * sizeof(int);
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_HALF_EDGE_MESH_H
+#define POLY_SYMMETRY_HALF_EDGE_MESH_H
+
+#include "meshData.h"
+
+#include <vector>
+
+using namespace std;
+
+/*
+    Half-edge view of the topology in a MeshData. There is one half-edge for 
+    each face corner, running from the corner's vertex to the next vertex in 
+    the winding order of the face, so half-edge indices are indices into 
+    MeshData::faceCorners.
+
+    The twin of a half-edge is the half-edge on the other face connected to 
+    the same edge, or -1 if the edge is on a border. The half-edges of an edge 
+    with more than two faces are linked in a cycle through their twins, in 
+    face order, so every face on the edge can be reached from any of them.
+*/
+class HalfEdgeMesh
+{
+public:
+    void                clear();
+    void                build(const MeshData &meshData);
+
+    int                 numberOfHalfEdges() const           { return (int) origin.size(); }
+    int                 destination(int h) const            { return origin[next[h]]; }
+    int                 faceSize(int f) const               { return faceHalfEdges[f + 1] - faceHalfEdges[f]; }
+    int                 findHalfEdge(int faceIndex, int edgeIndex) const;
+
+    size_t              memoryUsage() const;
+
+public:
+    vector<int>         origin;
+    vector<int>         next;
+    vector<int>         prev;
+    vector<int>         twin;
+    vector<int>         edge;
+    vector<int>         face;
+
+    // The half-edges of face f are faceHalfEdges[f] to faceHalfEdges[f + 1].
+    vector<int>         faceHalfEdges;
+};
+
+#endif
\ No newline at end of file
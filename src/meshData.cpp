@@ -8,10 +8,11 @@
 #include "util.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
 
 #include <maya/MDagPath.h>
+#include <maya/MFnMesh.h>
 #include <maya/MIntArray.h>
 #include <maya/MItMeshEdge.h>
 #include <maya/MItMeshPolygon.h>
@@ -19,6 +20,122 @@
 
 using namespace std;
 
+void AdjacencyList::clear()
+{
+    offsets.clear();
+    indices.clear();
+}
+
+void AdjacencyList::reserve(int numberOfRows, int numberOfIndices)
+{
+    offsets.reserve(numberOfRows + 1);
+    indices.reserve(numberOfIndices);
+}
+
+void AdjacencyList::appendRow(MIntArray &row, bool sortRow)
+{
+    if (offsets.empty()) { offsets.push_back(0); }
+
+    uint numberOfItems = row.length();
+
+    for (uint i = 0; i < numberOfItems; i++)
+    {
+        indices.push_back(row[i]);
+    }
+
+    if (sortRow)
+    {
+        sort(indices.end() - numberOfItems, indices.end());
+    }
+    offsets.push_back((int) indices.size());
+}
+
+void AdjacencyList::appendRow(const int* items, int numberOfItems)
+{
+    if (offsets.empty()) { offsets.push_back(0); }
+
+    indices.insert(indices.end(), items, items + numberOfItems);
+
+    sort(indices.end() - numberOfItems, indices.end());
+    offsets.push_back((int) indices.size());
+}
+
+void AdjacencyList::setRows(const vector<int> &rowSizes, vector<int> &rowIndices)
+{
+    int numberOfRows = (int) rowSizes.size();
+
+    offsets.resize(numberOfRows + 1);
+    offsets[0] = 0;
+
+    for (int i = 0; i < numberOfRows; i++)
+    {
+        offsets[i + 1] = offsets[i] + rowSizes[i];
+    }
+
+    indices.swap(rowIndices);
+}
+
+void AdjacencyList::sortRows()
+{
+    int numberOfRows = this->numberOfRows();
+
+    for (int i = 0; i < numberOfRows; i++)
+    {
+        sort(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+    }
+}
+
+/*
+    Builds the inverse of the source relation - row j lists every source row 
+    that contains j. Source rows are visited in order, so each row of the 
+    result comes out sorted without a sort pass. 
+*/
+void AdjacencyList::transpose(const AdjacencyList &source, int numberOfRows)
+{
+    int numberOfSourceRows = source.numberOfRows();
+
+    vector<int> lastSourceRow(numberOfRows, -1);
+
+    offsets.assign(numberOfRows + 1, 0);
+
+    for (int i = 0; i < numberOfSourceRows; i++)
+    {
+        for (const int &j : source[i])
+        {
+            if (j < 0 || lastSourceRow[j] == i) { continue; }
+
+            lastSourceRow[j] = i;
+            offsets[j + 1]++;
+        }
+    }
+
+    for (int j = 0; j < numberOfRows; j++)
+    {
+        offsets[j + 1] += offsets[j];
+    }
+
+    indices.resize(offsets[numberOfRows]);
+
+    vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    lastSourceRow.assign(numberOfRows, -1);
+
+    for (int i = 0; i < numberOfSourceRows; i++)
+    {
+        for (const int &j : source[i])
+        {
+            if (j < 0 || lastSourceRow[j] == i) { continue; }
+
+            lastSourceRow[j] = i;
+            indices[cursor[j]++] = i;
+        }
+    }
+}
+
+size_t AdjacencyList::memoryUsage() const
+{
+    return (offsets.capacity() + indices.capacity()) * sizeof(int);
+}
+
 MeshData::MeshData() {}
 
 MeshData::~MeshData()
@@ -31,43 +148,170 @@ void MeshData::clear()
     numberOfEdges = 0;
     numberOfFaces = 0;
     numberOfVertices = 0;
+    numberOfShells = 0;
+
+    vertexEdges.clear();
+    vertexFaces.clear();
+    vertexVertices.clear();
+
+    edgeFaces.clear();
+    edgeVertices.clear();
+
+    faceEdges.clear();
+    faceVertices.clear();
+
+    faceCorners.clear();
+    faceCornerEdges.clear();
+    vertexFaceCorners.clear();
+
+    vertexShells.clear();
+}
+
+size_t MeshData::memoryUsage() const
+{
+    return vertexEdges.memoryUsage() 
+        + vertexFaces.memoryUsage() 
+        + vertexVertices.memoryUsage() 
+        + edgeFaces.memoryUsage() 
+        + edgeVertices.memoryUsage() 
+        + faceEdges.memoryUsage() 
+        + faceVertices.memoryUsage()
+        + faceCorners.memoryUsage()
+        + faceCornerEdges.capacity() * sizeof(int)
+        + vertexFaceCorners.capacity() * sizeof(int)
+        + vertexShells.capacity() * sizeof(int);
+}
+
+/*
+    Gets the vertices before and after the vertex on the winding order of the face. 
+    Returns false if the vertex is not on the face.
+*/
+bool MeshData::getFaceVertexSiblings(int vertexIndex, int faceIndex, int &previousVertex, int &nextVertex) const
+{
+    int first = vertexFaces.offsets[vertexIndex];
+    int last = vertexFaces.offsets[vertexIndex + 1];
+
+    for (int i = first; i < last; i++)
+    {
+        if (vertexFaces.indices[i] != faceIndex) { continue; }
+
+        int faceStart = faceCorners.offsets[faceIndex];
+        int faceSize = faceCorners.offsets[faceIndex + 1] - faceStart;
+        int corner = vertexFaceCorners[i] - faceStart;
+
+        previousVertex = faceCorners.indices[faceStart + (corner + faceSize - 1) % faceSize];
+        nextVertex = faceCorners.indices[faceStart + (corner + 1) % faceSize];
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+    Checksum of the topology of a mesh, computed the way the given version 
+    computes it. The data is gathered into one buffer and hashed in one pass.
+*/
+uint64_t MeshData::getVertexChecksum(MDagPath &meshDagPath, ChecksumVersion version)
+{
+    return MeshData::getVertexChecksum(meshDagPath, version, MeshData::getChecksumAlgorithm(version));
+}
+
+uint64_t MeshData::getVertexChecksum(MDagPath &meshDagPath, ChecksumVersion version, ChecksumAlgorithm algorithm)
+{
+    vector<int> data;
+    MeshData::getVertexChecksumData(meshDagPath, version, data);
 
-    vertexData.clear();
-    edgeData.clear();
-    faceData.clear();  
+    PolyChecksum checksum(algorithm);
+    checksum.putBytes(data.data(), data.size() * sizeof(int));
+
+    return checksum.getResult64();
 }
 
-unsigned long MeshData::getVertexChecksum(MDagPath &meshDagPath)
+/*
+    The data the vertex checksum is computed from. 
+
+    For kVertexRingChecksum, the index of each vertex followed by the indices 
+    of its connected vertices. 
+
+    For kTopologyChecksum, the number of vertices and faces followed by the 
+    polygon counts and connects, which describe the topology completely and 
+    come out of MFnMesh without visiting each vertex.
+*/
+void MeshData::getVertexChecksumData(MDagPath &meshDagPath, ChecksumVersion version, vector<int> &data)
 {
-    PolyChecksum checksum;
+    data.clear();
+
+    if (version == kTopologyChecksum)
+    {
+        MFnMesh fnMesh(meshDagPath);
+
+        MIntArray counts;
+        MIntArray connects;
+
+        fnMesh.getVertices(counts, connects);
+
+        uint numberOfCounts = counts.length();
+        uint numberOfConnects = connects.length();
+
+        data.resize(2 + numberOfCounts + numberOfConnects);
+
+        data[0] = fnMesh.numVertices();
+        data[1] = (int) numberOfCounts;
+
+        if (numberOfCounts != 0)    { counts.get(data.data() + 2); }
+        if (numberOfConnects != 0)  { connects.get(data.data() + 2 + numberOfCounts); }
+
+        return;
+    }
 
     MItMeshVertex itVertex(meshDagPath);
+    MIntArray connectedVertices;
     
     while (!itVertex.isDone())
     {
-        int index = itVertex.index();
-        checksum.putBytes(&index, sizeof(index));
+        data.push_back(itVertex.index());
 
-        MIntArray connectedVertices;
         itVertex.getConnectedVertices(connectedVertices);
         uint numConnectedVertices = connectedVertices.length();
 
         for (uint i = 0; i < numConnectedVertices; i++)
         {
-            uint idx = connectedVertices[i];
-            checksum.putBytes(&idx, sizeof(idx));
+            data.push_back(connectedVertices[i]);
         }
 
         itVertex.next();
     }
+}
 
-    return checksum.getResult();
+/*
+    The hash each checksum version uses. The slicing CRC gives the same 
+    values as the legacy CRC, so kVertexRingChecksum matches older scenes.
+*/
+ChecksumAlgorithm MeshData::getChecksumAlgorithm(ChecksumVersion version)
+{
+    return version == kTopologyChecksum ? kXxHash64Checksum : kSlicingChecksum;
 }
 
-void MeshData::unpackMesh(MDagPath &meshDagPath)
+/*
+    Unpacks the mesh topology. By default the adjacency is derived from the 
+    bulk vertex and edge arrays of the mesh. The per-component iterator path 
+    is kept so the two can be cross-checked.
+*/
+void MeshData::unpackMesh(MDagPath &meshDagPath, bool useIterators)
 {
     this->clear();
-    
+
+    if (useIterators)
+    {
+        this->unpackMeshIterators(meshDagPath);
+    } else {
+        this->unpackMeshArrays(meshDagPath);
+    }
+}
+
+void MeshData::unpackMeshIterators(MDagPath &meshDagPath)
+{
     MItMeshEdge edges(meshDagPath);
     MItMeshPolygon faces(meshDagPath);
     MItMeshVertex vertices(meshDagPath);
@@ -76,34 +320,210 @@ void MeshData::unpackMesh(MDagPath &meshDagPath)
     this->unpackFaces(faces);
     this->unpackVertices(vertices);
 
-    this->unpackVertexSiblings();
+    this->unpackFaceCornerEdges();
+    this->unpackFaceCorners();
+    this->unpackShells();
+}
+
+void MeshData::unpackMeshArrays(MDagPath &meshDagPath)
+{
+    MFnMesh fnMesh(meshDagPath);
+
+    MIntArray counts;
+    MIntArray connects;
+
+    fnMesh.getVertices(counts, connects);
+
+    vector<int> polygonCounts(counts.length());
+    vector<int> polygonConnects(connects.length());
+
+    if (!polygonCounts.empty())     { counts.get(polygonCounts.data()); }
+    if (!polygonConnects.empty())   { connects.get(polygonConnects.data()); }
+
+    // Edges are read from the mesh, since edits can leave them numbered 
+    // differently from the order the faces first reach them.
+    int numberOfEdges = fnMesh.numEdges();
+    vector<int> edgeConnects(numberOfEdges * 2);
+
+    int2 edgeVertexPair;
+
+    for (int e = 0; e < numberOfEdges; e++)
+    {
+        fnMesh.getEdgeVertices(e, edgeVertexPair);
+
+        edgeConnects[e * 2] = edgeVertexPair[0];
+        edgeConnects[e * 2 + 1] = edgeVertexPair[1];
+    }
+
+    this->unpackTopology(fnMesh.numVertices(), polygonCounts, polygonConnects, edgeConnects);
+}
+
+/*
+    Numbers the edges of the polygons the way Maya does when it builds a 
+    mesh - in the order the face corners first reach them. Each corner is 
+    bucketed by its lower vertex, so finding the first corner of each edge 
+    is linear in the number of corners. Edited meshes can number their edges 
+    differently, so unpackMeshArrays reads the edges of a mesh instead.
+*/
+void MeshData::getEdgeConnects(int numberOfVertices, const vector<int> &polygonCounts, const vector<int> &polygonConnects, vector<int> &edgeConnects)
+{
+    edgeConnects.clear();
+
+    int numberOfCorners = (int) polygonConnects.size();
+
+    vector<int> nextCorners(numberOfCorners);
+
+    for (int f = 0, first = 0; f < (int) polygonCounts.size(); first += polygonCounts[f++])
+    {
+        int last = first + polygonCounts[f];
+
+        if (last > numberOfCorners) { return; }
+
+        for (int c = first; c < last; c++)
+        {
+            nextCorners[c] = c + 1 < last ? c + 1 : first;
+        }
+    }
+
+    vector<int> bucketOffsets(numberOfVertices + 1, 0);
+
+    for (int c = 0; c < numberOfCorners; c++)
+    {
+        int vertex0 = polygonConnects[c];
+        int vertex1 = polygonConnects[nextCorners[c]];
+
+        if ((unsigned) vertex0 >= (unsigned) numberOfVertices || (unsigned) vertex1 >= (unsigned) numberOfVertices) { return; }
+
+        bucketOffsets[min(vertex0, vertex1) + 1]++;
+    }
+
+    for (int v = 0; v < numberOfVertices; v++)
+    {
+        bucketOffsets[v + 1] += bucketOffsets[v];
+    }
+
+    vector<int> bucketCorners(numberOfCorners);
+    vector<int> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+
+    for (int c = 0; c < numberOfCorners; c++)
+    {
+        int vertex0 = polygonConnects[c];
+        int vertex1 = polygonConnects[nextCorners[c]];
+
+        bucketCorners[fill[min(vertex0, vertex1)]++] = c;
+    }
+
+    // The first corner on each edge. Buckets hold corners in order, so the
+    // first corner seen with a given upper vertex is the first on its edge.
+    vector<int> firstCorners(numberOfCorners);
+    vector<int> seen(numberOfVertices, -1);
+
+    for (int v = 0; v < numberOfVertices; v++)
+    {
+        for (int i = bucketOffsets[v]; i < bucketOffsets[v + 1]; i++)
+        {
+            int c = bucketCorners[i];
+            int upper = max(polygonConnects[c], polygonConnects[nextCorners[c]]);
+
+            if (seen[upper] == -1) { seen[upper] = c; }
+
+            firstCorners[c] = seen[upper];
+        }
+
+        for (int i = bucketOffsets[v]; i < bucketOffsets[v + 1]; i++)
+        {
+            int c = bucketCorners[i];
+            seen[max(polygonConnects[c], polygonConnects[nextCorners[c]])] = -1;
+        }
+    }
+
+    for (int c = 0; c < numberOfCorners; c++)
+    {
+        if (firstCorners[c] != c) { continue; }
+
+        edgeConnects.push_back(polygonConnects[c]);
+        edgeConnects.push_back(polygonConnects[nextCorners[c]]);
+    }
+}
+
+/*
+    Builds every adjacency relation from the polygon vertex counts, the 
+    polygon vertex indices, and the vertex pair of each edge, using 
+    counting passes that are linear in the size of the mesh. 
+
+    Edge indices cannot be derived from the polygons alone, so the edge 
+    vertex pairs are taken as given to keep the edge numbering of the mesh.
+*/
+void MeshData::unpackTopology(int numberOfVertices, vector<int> &polygonCounts, vector<int> &polygonConnects, vector<int> &edgeConnects)
+{
+    this->numberOfVertices = numberOfVertices;
+    this->numberOfEdges = (int) edgeConnects.size() / 2;
+    this->numberOfFaces = (int) polygonCounts.size();
+
+    vector<int> edgeCounts(this->numberOfEdges, 2);
+    vector<int> connects(edgeConnects);
+
+    edgeVertices.setRows(edgeCounts, connects);
+    edgeVertices.sortRows();
+
+    vertexEdges.transpose(edgeVertices, this->numberOfVertices);
+
+    vertexVertices.offsets = vertexEdges.offsets;
+    vertexVertices.indices.resize(vertexEdges.indices.size());
+
+    for (int v = 0; v < this->numberOfVertices; v++)
+    {
+        for (int i = vertexEdges.offsets[v]; i < vertexEdges.offsets[v + 1]; i++)
+        {
+            IndexRange edge = edgeVertices[vertexEdges.indices[i]];
+            vertexVertices.indices[i] = edge[0] == v ? edge[1] : edge[0];
+        }
+    }
+
+    vertexVertices.sortRows();
+
+    connects = polygonConnects;
+    faceCorners.setRows(polygonCounts, connects);
+
+    this->unpackFaceCornerEdges();
+
+    connects = polygonConnects;
+    faceVertices.setRows(polygonCounts, connects);
+    faceVertices.sortRows();
+
+    vector<int> polygonEdges(faceCornerEdges);
+
+    faceEdges.setRows(polygonCounts, polygonEdges);
+    faceEdges.sortRows();
+
+    vertexFaces.transpose(faceVertices, this->numberOfVertices);
+    edgeFaces.transpose(faceEdges, this->numberOfEdges);
+
+    this->unpackFaceCorners();
+    this->unpackShells();
 }
 
 void MeshData::unpackEdges(MItMeshEdge &edges)
 {
     this->numberOfEdges = edges.count();
-    this->edgeData.resize(this->numberOfEdges);
 
-    MIntArray connectedEdges;
+    edgeVertices.reserve(this->numberOfEdges, this->numberOfEdges * 2);
+    edgeFaces.reserve(this->numberOfEdges, this->numberOfEdges * 2);
+
     MIntArray connectedFaces;
+    int connectedVertices[2];
 
     edges.reset();
 
     while (!edges.isDone())
     {
-        EdgeData &edge = edgeData[edges.index()];
+        connectedVertices[0] = edges.index(0);
+        connectedVertices[1] = edges.index(1);
 
-        edge.connectedVertices.resize(2);
-        edge.connectedVertices[0] = edges.index(0);
-        edge.connectedVertices[1] = edges.index(1);
-
-        sort(edge.connectedVertices.begin(), edge.connectedVertices.end());
-        
         edges.getConnectedFaces(connectedFaces);
-        edges.getConnectedEdges(connectedEdges);
 
-        insertAll(connectedFaces, edge.connectedFaces);
-        insertAll(connectedEdges, edge.connectedEdges);
+        edgeVertices.appendRow(connectedVertices, 2);
+        edgeFaces.appendRow(connectedFaces);
 
         edges.next();
     }
@@ -112,25 +532,24 @@ void MeshData::unpackEdges(MItMeshEdge &edges)
 void MeshData::unpackFaces(MItMeshPolygon &faces)
 {
     this->numberOfFaces = faces.count();
-    this->faceData.resize(this->numberOfFaces);
+
+    faceEdges.reserve(this->numberOfFaces, this->numberOfFaces * 4);
+    faceVertices.reserve(this->numberOfFaces, this->numberOfFaces * 4);
+    faceCorners.reserve(this->numberOfFaces, this->numberOfFaces * 4);
 
     MIntArray connectedEdges;
-    MIntArray connectedFaces;
     MIntArray connectedVertices;
 
     faces.reset();
 
     while (!faces.isDone())
     {
-        FaceData &face = faceData[faces.index()];
-
         faces.getEdges(connectedEdges);
-        faces.getConnectedFaces(connectedFaces);
         faces.getVertices(connectedVertices);
 
-        insertAll(connectedFaces, face.connectedFaces);
-        insertAll(connectedEdges, face.connectedEdges);
-        insertAll(connectedVertices, face.connectedVertices);
+        faceEdges.appendRow(connectedEdges);
+        faceVertices.appendRow(connectedVertices);
+        faceCorners.appendRow(connectedVertices, false);
 
         faces.next();
     }
@@ -139,7 +558,10 @@ void MeshData::unpackFaces(MItMeshPolygon &faces)
 void MeshData::unpackVertices(MItMeshVertex &vertices)
 {
     this->numberOfVertices = vertices.count();
-    this->vertexData.resize(this->numberOfVertices);
+
+    vertexEdges.reserve(this->numberOfVertices, this->numberOfEdges * 2);
+    vertexFaces.reserve(this->numberOfVertices, this->numberOfFaces * 4);
+    vertexVertices.reserve(this->numberOfVertices, this->numberOfEdges * 2);
 
     MIntArray connectedEdges;
     MIntArray connectedFaces;
@@ -149,52 +571,113 @@ void MeshData::unpackVertices(MItMeshVertex &vertices)
 
     while (!vertices.isDone())
     {
-        VertexData &vertex = vertexData[vertices.index()];
-
         vertices.getConnectedEdges(connectedEdges);
         vertices.getConnectedFaces(connectedFaces);
         vertices.getConnectedVertices(connectedVertices);
 
-        insertAll(connectedFaces, vertex.connectedFaces);
-        insertAll(connectedEdges, vertex.connectedEdges);
-        insertAll(connectedVertices, vertex.connectedVertices);
+        vertexEdges.appendRow(connectedEdges);
+        vertexFaces.appendRow(connectedFaces);
+        vertexVertices.appendRow(connectedVertices);
 
         vertices.next();
     }
 }
 
-void MeshData::unpackVertexSiblings()
+/*
+    Finds the edge from each face corner to the next corner on the face.
+*/
+void MeshData::unpackFaceCornerEdges()
 {
-    for (int vertexIndex = 0; vertexIndex < this->numberOfVertices; vertexIndex++)
+    faceCornerEdges.resize(faceCorners.indices.size());
+
+    for (int f = 0; f < this->numberOfFaces; f++)
     {
-        for (int &faceIndex : vertexData[vertexIndex].connectedFaces)
+        int first = faceCorners.offsets[f];
+        int last = faceCorners.offsets[f + 1];
+
+        for (int c = first; c < last; c++)
         {
-            vertexData[vertexIndex].faceVertexSiblings.emplace(faceIndex, vector<int>());
+            int vertex0 = faceCorners.indices[c];
+            int vertex1 = faceCorners.indices[c + 1 < last ? c + 1 : first];
+
+            faceCornerEdges[c] = -1;
 
-            for (int &faceVertexIndex : faceData[faceIndex].connectedVertices)
+            for (const int &e : vertexEdges[vertex0])
             {
-                if (contains(vertexData[faceVertexIndex].connectedVertices, vertexIndex))
+                IndexRange edge = edgeVertices[e];
+
+                if (edge[0] == vertex1 || edge[1] == vertex1)
                 {
-                    vertexData[vertexIndex].faceVertexSiblings[faceIndex].push_back(faceVertexIndex);
+                    faceCornerEdges[c] = e;
+                    break;
                 }
             }
-
-            sort(
-                vertexData[vertexIndex].faceVertexSiblings[faceIndex].begin(), 
-                vertexData[vertexIndex].faceVertexSiblings[faceIndex].end()
-            );
         }
     }
 }
 
-void MeshData::insertAll(MIntArray &src, vector<int> &dest)
+/*
+    Finds the corner of each vertex on each of its faces, so that the vertices 
+    next to it on a face can be looked up without searching the face.
+*/
+void MeshData::unpackFaceCorners()
 {
-    dest.resize(src.length());
+    vertexFaceCorners.resize(vertexFaces.indices.size());
 
-    for (uint i = 0; i < src.length(); i++)
+    for (int v = 0; v < this->numberOfVertices; v++)
     {
-        dest[i] = src[i];
+        for (int i = vertexFaces.offsets[v]; i < vertexFaces.offsets[v + 1]; i++)
+        {
+            int f = vertexFaces.indices[i];
+
+            vertexFaceCorners[i] = -1;
+
+            for (int c = faceCorners.offsets[f]; c < faceCorners.offsets[f + 1]; c++)
+            {
+                if (faceCorners.indices[c] == v)
+                {
+                    vertexFaceCorners[i] = c;
+                    break;
+                }
+            }
+        }
     }
+}
+
+/*
+    Numbers the connected shells of the mesh by flooding out from each 
+    vertex that is not on a shell yet.
+*/
+void MeshData::unpackShells()
+{
+    vertexShells.assign(this->numberOfVertices, -1);
+    numberOfShells = 0;
+
+    vector<int> vertexStack;
+    vertexStack.reserve(this->numberOfVertices);
+
+    for (int v = 0; v < this->numberOfVertices; v++)
+    {
+        if (vertexShells[v] != -1) { continue; }
+
+        vertexShells[v] = numberOfShells;
+        vertexStack.push_back(v);
+
+        while (!vertexStack.empty())
+        {
+            int vertexIndex = vertexStack.back();
+            vertexStack.pop_back();
 
-    sort(dest.begin(), dest.end());
+            for (int i : vertexVertices[vertexIndex])
+            {
+                if (vertexShells[i] == -1)
+                {
+                    vertexShells[i] = numberOfShells;
+                    vertexStack.push_back(i);
+                }
+            }
+        }
+
+        numberOfShells++;
+    }
 }
\ No newline at end of file
@@ -6,30 +6,61 @@
 #ifndef MESH_DATA_CMD_H
 #define MESH_DATA_CMD_H
 
+#include "polyChecksum.h"
+#include "util.h"
+
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
 
 #include <maya/MDagPath.h>
+#include <maya/MIntArray.h>
 #include <maya/MItMeshEdge.h>
 #include <maya/MItMeshPolygon.h>
 #include <maya/MItMeshVertex.h>
 
 using namespace std;
 
-struct ComponentData
+/*
+    How the vertex checksum of a mesh is computed. The version a node was 
+    created with is stored on it, so older scenes keep matching their meshes.
+*/
+enum ChecksumVersion
 {
-    vector<int> connectedVertices;
-    vector<int> connectedEdges;
-    vector<int> connectedFaces;
+    // CRC of each vertex index followed by its connected vertices. Slow, 
+    // because it walks the mesh with MItMeshVertex.
+    kVertexRingChecksum = 0,
+
+    // xxHash64 of the polygon counts and connects, read in bulk.
+    kTopologyChecksum = 1
 };
 
-struct VertexData : ComponentData
+/*
+    Compressed sparse row adjacency. The components adjacent to component i 
+    are stored in indices[offsets[i]] to indices[offsets[i + 1]], sorted 
+    unless noted otherwise.
+*/
+class AdjacencyList
 {
-    unordered_map<int,vector<int>> faceVertexSiblings;
+public:
+    void                clear();
+    void                reserve(int numberOfRows, int numberOfIndices);
+    void                appendRow(MIntArray &row, bool sortRow=true);
+    void                appendRow(const int* items, int numberOfItems);
+
+    void                setRows(const vector<int> &rowSizes, vector<int> &rowIndices);
+    void                sortRows();
+    void                transpose(const AdjacencyList &source, int numberOfRows);
+
+    int                 numberOfRows() const                { return offsets.empty() ? 0 : (int) offsets.size() - 1; }
+    int                 rowSize(int i) const                { return offsets[i + 1] - offsets[i]; }
+    IndexRange          operator[](int i) const             { return IndexRange(indices.data() + offsets[i], indices.data() + offsets[i + 1]); }
+
+    size_t              memoryUsage() const;
+
+public:
+    vector<int>         offsets;
+    vector<int>         indices;
 };
-    
-struct EdgeData : ComponentData {};
-struct FaceData : ComponentData {};
 
 class MeshData
 {
@@ -37,28 +68,58 @@ public:
     MeshData();
     virtual ~MeshData();
 
-    virtual void            unpackMesh(MDagPath &meshDagPath);
+    virtual void            unpackMesh(MDagPath &meshDagPath, bool useIterators=false);
+    virtual void            unpackTopology(int numberOfVertices, vector<int> &polygonCounts, vector<int> &polygonConnects, vector<int> &edgeConnects);
+    static void             getEdgeConnects(int numberOfVertices, const vector<int> &polygonCounts, const vector<int> &polygonConnects, vector<int> &edgeConnects);
     virtual void            clear();
 
-    static unsigned long    getVertexChecksum(MDagPath &meshDagPath);
+    virtual size_t          memoryUsage() const;
+
+    bool                    getFaceVertexSiblings(int vertexIndex, int faceIndex, int &previousVertex, int &nextVertex) const;
+
+    static uint64_t         getVertexChecksum(MDagPath &meshDagPath, ChecksumVersion version=kTopologyChecksum);
+    static uint64_t         getVertexChecksum(MDagPath &meshDagPath, ChecksumVersion version, ChecksumAlgorithm algorithm);
+    static void             getVertexChecksumData(MDagPath &meshDagPath, ChecksumVersion version, vector<int> &data);
+    static ChecksumAlgorithm getChecksumAlgorithm(ChecksumVersion version);
 
 private:
-    
+    virtual void        unpackMeshArrays(MDagPath &meshDagPath);
+    virtual void        unpackMeshIterators(MDagPath &meshDagPath);
+
     virtual void        unpackEdges(MItMeshEdge &edges);
     virtual void        unpackFaces(MItMeshPolygon &faces);
     virtual void        unpackVertices(MItMeshVertex &vertices);
-    virtual void        unpackVertexSiblings();
-    
-    virtual void        insertAll(MIntArray &src, vector<int> &dest);
+    virtual void        unpackFaceCornerEdges();
+    virtual void        unpackFaceCorners();
+    virtual void        unpackShells();
 
 public:
     int                     numberOfVertices = 0;
     int                     numberOfEdges = 0;
     int                     numberOfFaces = 0;
+    int                     numberOfShells = 0;
     
-    vector<VertexData>      vertexData;
-    vector<EdgeData>        edgeData;
-    vector<FaceData>        faceData;
+    AdjacencyList           vertexEdges;
+    AdjacencyList           vertexFaces;
+    AdjacencyList           vertexVertices;
+
+    AdjacencyList           edgeFaces;
+    AdjacencyList           edgeVertices;
+
+    AdjacencyList           faceEdges;
+    AdjacencyList           faceVertices;
+
+    // Face vertices in winding order, one entry per face corner. Not sorted.
+    AdjacencyList           faceCorners;
+
+    // Parallel to faceCorners.indices - the edge from each face corner to the next.
+    vector<int>             faceCornerEdges;
+
+    // Parallel to vertexFaces.indices - the face corner of the vertex on each of its faces.
+    vector<int>             vertexFaceCorners;
+
+    // The connected shell each vertex is on, numbered from 0.
+    vector<int>             vertexShells;
 
     unsigned long           vertexChecksum;
 };
@@ -0,0 +1,265 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "mirrorPlane.h"
+#include "parseArgs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <maya/MArgDatabase.h>
+#include <maya/MDagPath.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MGlobal.h>
+#include <maya/MMatrix.h>
+#include <maya/MPoint.h>
+#include <maya/MStatus.h>
+#include <maya/MString.h>
+#include <maya/MSyntax.h>
+#include <maya/MVector.h>
+
+// Center vertices may be this far from the plane, relative to the size of the mesh.
+#define MIRROR_PLANE_TOLERANCE 1.0e-3
+
+using namespace std;
+
+void MirrorPlane::addFlags(MSyntax &syntax)
+{
+    syntax.addFlag(MIRROR_AXIS_FLAG, MIRROR_AXIS_LONG_FLAG, MSyntax::kString);
+
+    syntax.addFlag(
+        MIRROR_PLANE_FLAG,
+        MIRROR_PLANE_LONG_FLAG,
+        MSyntax::kDouble, MSyntax::kDouble, MSyntax::kDouble,
+        MSyntax::kDouble, MSyntax::kDouble, MSyntax::kDouble
+    );
+
+    syntax.addFlag(MIRROR_PLANE_TRANSFORM_FLAG, MIRROR_PLANE_TRANSFORM_LONG_FLAG, MSyntax::kSelectionItem);
+}
+
+MStatus MirrorPlane::parseArguments(MArgDatabase &argsData)
+{
+    MStatus status;
+
+    int axis = 0;
+
+    if (argsData.isFlagSet(MIRROR_AXIS_FLAG))
+    {
+        MString axisName;
+        argsData.getFlagArgument(MIRROR_AXIS_FLAG, 0, axisName);
+
+        if      (axisName == "x") { axis = 0; }
+        else if (axisName == "y") { axis = 1; }
+        else if (axisName == "z") { axis = 2; }
+        else {
+            MString errorMsg("The ^1s flag must be x, y or z.");
+            errorMsg.format(errorMsg, MString(MIRROR_AXIS_LONG_FLAG));
+
+            MGlobal::displayError(errorMsg);
+            return MStatus::kFailure;
+        }
+    }
+
+    this->point = MPoint();
+    this->normal = MVector();
+    this->normal[axis] = 1.0;
+    this->isWorldSpace = false;
+
+    bool hasPlane = argsData.isFlagSet(MIRROR_PLANE_FLAG);
+    bool hasPlaneTransform = argsData.isFlagSet(MIRROR_PLANE_TRANSFORM_FLAG);
+
+    if (hasPlane && hasPlaneTransform)
+    {
+        MString errorMsg("The ^1s and ^2s flags cannot be used together.");
+        errorMsg.format(errorMsg, MString(MIRROR_PLANE_LONG_FLAG), MString(MIRROR_PLANE_TRANSFORM_LONG_FLAG));
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    if (hasPlane)
+    {
+        for (unsigned i = 0; i < 3; i++)
+        {
+            argsData.getFlagArgument(MIRROR_PLANE_FLAG, i, this->point[i]);
+            argsData.getFlagArgument(MIRROR_PLANE_FLAG, i + 3, this->normal[i]);
+        }
+    } else if (hasPlaneTransform) {
+        MDagPath transform;
+
+        status = parseArgs::getDagPathArgument(argsData, MIRROR_PLANE_TRANSFORM_FLAG, transform, true);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        if (!parseArgs::isNodeType(transform, MFn::kTransform))
+        {
+            MString errorMsg("The ^1s flag requires a transform.");
+            errorMsg.format(errorMsg, MString(MIRROR_PLANE_TRANSFORM_LONG_FLAG));
+
+            MGlobal::displayError(errorMsg);
+            return MStatus::kFailure;
+        }
+
+        // Maya matrices are row major - the rows are the axes and the position.
+        MMatrix matrix = transform.inclusiveMatrix();
+
+        this->point = MPoint(matrix(3, 0), matrix(3, 1), matrix(3, 2));
+        this->normal = MVector(matrix(axis, 0), matrix(axis, 1), matrix(axis, 2));
+        this->isWorldSpace = true;
+    }
+
+    if (this->normal.length() < 1.0e-9)
+    {
+        MGlobal::displayError("The mirror plane needs a normal that is not zero length.");
+        return MStatus::kFailure;
+    }
+
+    this->normal.normalize();
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Moves a plane given by a transform into the object space of the mesh,
+    if the command works in object space. Other planes are already in the
+    space of the command.
+*/
+void MirrorPlane::setSpace(const MDagPath &mesh, MSpace::Space space)
+{
+    if (!this->isWorldSpace || space == MSpace::kWorld) { return; }
+
+    MMatrix matrix = mesh.inclusiveMatrix();
+    MMatrix inverseMatrix = mesh.inclusiveMatrixInverse();
+
+    this->point = this->point * inverseMatrix;
+
+    // Normals move by the inverse transpose, so the plane stays a plane
+    // when the mesh is scaled unevenly.
+    MVector objectNormal;
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        objectNormal[i] = matrix(i, 0) * normal[0] + matrix(i, 1) * normal[1] + matrix(i, 2) * normal[2];
+    }
+
+    this->normal = objectNormal.normal();
+    this->isWorldSpace = false;
+}
+
+/*
+    The reflection across the plane as an affine matrix for PointRemapArgs:
+
+        p' = (I - 2nn) p + 2 (n . c) n
+*/
+void MirrorPlane::getReflection(float matrix[3][4]) const
+{
+    this->getLinearReflection(matrix);
+
+    double distance = this->normal * (this->point - MPoint());
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        matrix[i][3] = (float) (2.0 * distance * this->normal[i]);
+    }
+}
+
+/*
+    The reflection without the translation, for mirroring offsets instead
+    of points.
+*/
+void MirrorPlane::getLinearReflection(float matrix[3][4]) const
+{
+    for (unsigned i = 0; i < 3; i++)
+    {
+        for (unsigned j = 0; j < 3; j++)
+        {
+            matrix[i][j] = (float) ((i == j ? 1.0 : 0.0) - 2.0 * this->normal[i] * this->normal[j]);
+        }
+
+        matrix[i][3] = 0.0f;
+    }
+}
+
+/*
+    Warns if the center vertices of the mesh are not on the plane, which
+    means the plane does not match the symmetry the tables were built for.
+    If checkOffset is false the plane may be anywhere along its normal, and
+    only its orientation is checked.
+*/
+void MirrorPlane::checkCenterVertices(
+    const MFloatPointArray &points,
+    const int8_t* vertexSides,
+    const MDagPath &mesh,
+    bool checkOffset
+) const {
+    unsigned numberOfPoints = points.length();
+
+    if (numberOfPoints == 0) { return; }
+
+    float lo[3] = {points[0].x, points[0].y, points[0].z};
+    float hi[3] = {points[0].x, points[0].y, points[0].z};
+
+    double distance = this->normal * (this->point - MPoint());
+    double distanceSum = 0.0;
+    int numberOfCenterVertices = 0;
+
+    for (unsigned i = 0; i < numberOfPoints; i++)
+    {
+        const MFloatPoint &p = points[i];
+
+        lo[0] = min(lo[0], p.x); lo[1] = min(lo[1], p.y); lo[2] = min(lo[2], p.z);
+        hi[0] = max(hi[0], p.x); hi[1] = max(hi[1], p.y); hi[2] = max(hi[2], p.z);
+
+        if (vertexSides[i] == 0)
+        {
+            distanceSum += normal[0] * p.x + normal[1] * p.y + normal[2] * p.z;
+            numberOfCenterVertices++;
+        }
+    }
+
+    if (numberOfCenterVertices == 0) { return; }
+
+    if (!checkOffset)
+    {
+        distance = distanceSum / numberOfCenterVertices;
+    }
+
+    MVector size(hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]);
+    double tolerance = max(size.length() * MIRROR_PLANE_TOLERANCE, 1.0e-6);
+
+    int numberOfMisses = 0;
+    double maxDistance = 0.0;
+
+    for (unsigned i = 0; i < numberOfPoints; i++)
+    {
+        if (vertexSides[i] != 0) { continue; }
+
+        const MFloatPoint &p = points[i];
+        double d = fabs(normal[0] * p.x + normal[1] * p.y + normal[2] * p.z - distance);
+
+        if (d > tolerance)
+        {
+            numberOfMisses++;
+            maxDistance = max(maxDistance, d);
+        }
+    }
+
+    if (numberOfMisses != 0)
+    {
+        MString maxDistanceStr;
+        maxDistanceStr += maxDistance;
+
+        MString warningMsg("^1s of the ^2s center vertices of ^3s are off the mirror plane, by up to ^4s. Check the mirror axis and plane.");
+        warningMsg.format(
+            warningMsg,
+            MString() + numberOfMisses,
+            MString() + numberOfCenterVertices,
+            mesh.partialPathName(),
+            maxDistanceStr
+        );
+
+        MGlobal::displayWarning(warningMsg);
+    }
+}
\ No newline at end of file
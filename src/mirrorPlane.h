@@ -0,0 +1,67 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_MIRROR_PLANE_H
+#define POLY_SYMMETRY_MIRROR_PLANE_H
+
+#include <cstdint>
+
+#include <maya/MArgDatabase.h>
+#include <maya/MDagPath.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MPoint.h>
+#include <maya/MStatus.h>
+#include <maya/MSyntax.h>
+#include <maya/MVector.h>
+
+#define MIRROR_AXIS_FLAG "-ax"
+#define MIRROR_AXIS_LONG_FLAG "-axis"
+
+#define MIRROR_PLANE_FLAG "-pl"
+#define MIRROR_PLANE_LONG_FLAG "-plane"
+
+#define MIRROR_PLANE_TRANSFORM_FLAG "-pt"
+#define MIRROR_PLANE_TRANSFORM_LONG_FLAG "-planeTransform"
+
+using namespace std;
+
+/*
+    The plane polyFlip and polyMirror reflect points across. By default it
+    is the YZ plane through the origin of the space the command works in.
+
+        -axis x|y|z             the normal of the plane
+        -plane px py pz nx ny nz
+                                a point on the plane and its normal, in the
+                                space the command works in
+        -planeTransform name    the plane through the world position of a
+                                transform, normal to its -axis
+*/
+class MirrorPlane
+{
+public:
+    static void         addFlags(MSyntax &syntax);
+
+    MStatus             parseArguments(MArgDatabase &argsData);
+    void                setSpace(const MDagPath &mesh, MSpace::Space space);
+
+    void                getReflection(float matrix[3][4]) const;
+    void                getLinearReflection(float matrix[3][4]) const;
+
+    void                checkCenterVertices(
+                            const MFloatPointArray &points,
+                            const int8_t* vertexSides,
+                            const MDagPath &mesh,
+                            bool checkOffset
+                        ) const;
+
+public:
+    MPoint              point;
+    MVector             normal = MVector(1.0, 0.0, 0.0);
+
+private:
+    bool                isWorldSpace = false;
+};
+
+#endif
\ No newline at end of file
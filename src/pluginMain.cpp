@@ -10,7 +10,9 @@
 #include "polySymmetryTool.h"
 #include "polySymmetryCmd.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
+#include "threadPool.h"
 
 #include <maya/MFnPlugin.h>
 #include <maya/MGlobal.h>
@@ -34,6 +36,9 @@ MString PolySymmetryCommand::COMMAND_NAME           = "polySymmetry";
 MString PolySymmetryNode::NODE_NAME                 = "polySymmetryData";
 MTypeId PolySymmetryNode::NODE_ID                   = 0x00126b0d;
 
+MString PolySymmetryTables::TYPE_NAME               = "polySymmetryTables";
+MTypeId PolySymmetryTables::TYPE_ID                 = 0x00126b0e;
+
 #define REGISTER_COMMAND(CMD) CHECK_MSTATUS_AND_RETURN_IT(fnPlugin.registerCommand(CMD::COMMAND_NAME, CMD::creator, CMD::getSyntax));
 #define DEREGISTER_COMMAND(CMD) CHECK_MSTATUS_AND_RETURN_IT(fnPlugin.deregisterCommand(CMD::COMMAND_NAME))
 
@@ -54,6 +59,14 @@ MStatus initializePlugin(MObject obj)
 
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = fnPlugin.registerData(
+        PolySymmetryTables::TYPE_NAME,
+        PolySymmetryTables::TYPE_ID,
+        PolySymmetryTables::creator
+    );
+
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = fnPlugin.registerNode(
 	    PolySymmetryNode::NODE_NAME,
         PolySymmetryNode::NODE_ID,
@@ -73,6 +86,9 @@ MStatus initializePlugin(MObject obj)
     status = PolySymmetryCache::initialize();
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = ThreadPool::initialize();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     if (MGlobal::mayaState() == MGlobal::kInteractive)
     {
         status = MGlobal::executePythonCommand("import polySymmetry");
@@ -98,6 +114,9 @@ MStatus uninitializePlugin(MObject obj)
     status = PolySymmetryCache::uninitialize();
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = ThreadPool::uninitialize();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = fnPlugin.deregisterContextCommand(
         PolySymmetryContextCmd::COMMAND_NAME, 
         PolySymmetryCommand::COMMAND_NAME
@@ -114,6 +133,9 @@ MStatus uninitializePlugin(MObject obj)
     status = fnPlugin.deregisterNode(PolySymmetryNode::NODE_ID);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = fnPlugin.deregisterData(PolySymmetryTables::TYPE_ID);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     if (MGlobal::mayaState() == MGlobal::kInteractive && menuCreated)
     {
         status = MGlobal::executePythonCommand("import polySymmetry");
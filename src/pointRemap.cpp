@@ -0,0 +1,256 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "pointRemap.h"
+#include "threadPool.h"
+
+#include <algorithm>
+
+#include <maya/MFloatPointArray.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define POINT_REMAP_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(POINT_REMAP_AVX2) && !defined(_MSC_VER)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+using namespace std;
+
+/*
+    Every output point depends only on the inputs, so large meshes are 
+    split into chunks that are remapped in parallel.
+*/
+void PointRemap::remap(const PointRemapArgs &args)
+{
+    int numberOfPoints = args.numberOfPoints;
+
+    if (numberOfPoints < POINT_REMAP_PARALLEL_THRESHOLD || ThreadPool::numberOfThreads() == 1)
+    {
+        PointRemap::remap(args, 0, numberOfPoints);
+        return;
+    }
+
+    int numberOfChunks = (numberOfPoints + POINT_REMAP_CHUNK_SIZE - 1) / POINT_REMAP_CHUNK_SIZE;
+
+    ThreadPool::parallelFor(
+        numberOfChunks,
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * POINT_REMAP_CHUNK_SIZE;
+            PointRemap::remap(args, first, min(first + POINT_REMAP_CHUNK_SIZE, numberOfPoints));
+        }
+    );
+}
+
+/*
+    Remaps the points in [begin, end). Separate ranges can be remapped at 
+    the same time.
+*/
+void PointRemap::remap(const PointRemapArgs &args, int begin, int end)
+{
+    if (begin >= end) { return; }
+
+#if defined(POINT_REMAP_AVX2)
+    static const bool hasAvx2 = PointRemap::hasAvx2();
+
+    if (hasAvx2)
+    {
+        PointRemap::remapAvx2(args, begin, end);
+        return;
+    }
+#endif
+
+    PointRemap::remapScalar(args, begin, end);
+}
+
+static inline int getMirrorIndex(const PointRemapArgs &args, int i)
+{
+    int o = args.symmetry[i];
+    return (unsigned) o < (unsigned) args.numberOfPoints ? o : i;
+}
+
+void PointRemap::remapScalar(const PointRemapArgs &args, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        int o = getMirrorIndex(args, i);
+
+        const float* p = args.points + 4 * o;
+        float* out = args.out + 4 * i;
+
+        float x = p[0];
+        float y = p[1];
+        float z = p[2];
+
+        if (args.offsets != nullptr)
+        {
+            const float* offset = args.offsets + 4 * o;
+
+            x -= offset[0];
+            y -= offset[1];
+            z -= offset[2];
+        }
+
+        const float (*m)[4] = args.matrix;
+
+        float mx = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+        float my = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+        float mz = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+
+        x = mx;
+        y = my;
+        z = mz;
+
+        if (args.add != nullptr)
+        {
+            const float* add = args.add + 4 * i;
+
+            x += add[0];
+            y += add[1];
+            z += add[2];
+        }
+
+        if (args.subtract != nullptr)
+        {
+            const float* subtract = args.subtract + 4 * i;
+
+            x -= subtract[0];
+            y -= subtract[1];
+            z -= subtract[2];
+        }
+
+        out[0] = x;
+        out[1] = y;
+        out[2] = z;
+        out[3] = 1.0f;
+    }
+}
+
+#if defined(POINT_REMAP_AVX2)
+
+/*
+    Two points to a register. The mirrored points are gathered with two 
+    unaligned 128-bit loads, which is faster than a gather instruction for
+    four-float points.
+*/
+AVX2_FUNCTION static inline __m256 gatherPoints(const float* points, int o0, int o1)
+{
+    __m256 lo = _mm256_castps128_ps256(_mm_loadu_ps(points + 4 * o0));
+    return _mm256_insertf128_ps(lo, _mm_loadu_ps(points + 4 * o1), 1);
+}
+
+/*
+    A column of the remap matrix, for both points in a register.
+*/
+AVX2_FUNCTION static inline __m256 getColumn(const PointRemapArgs &args, int column)
+{
+    const float (*m)[4] = args.matrix;
+
+    return _mm256_setr_ps(
+        m[0][column], m[1][column], m[2][column], 0.0f,
+        m[0][column], m[1][column], m[2][column], 0.0f
+    );
+}
+
+AVX2_FUNCTION void PointRemap::remapAvx2(const PointRemapArgs &args, int begin, int end)
+{
+    const __m256 column0 = getColumn(args, 0);
+    const __m256 column1 = getColumn(args, 1);
+    const __m256 column2 = getColumn(args, 2);
+    const __m256 translation = getColumn(args, 3);
+
+    const __m256 w = _mm256_set1_ps(1.0f);
+
+    int i = begin;
+
+    for (; i + 1 < end; i += 2)
+    {
+        int o0 = getMirrorIndex(args, i);
+        int o1 = getMirrorIndex(args, i + 1);
+
+        __m256 p = gatherPoints(args.points, o0, o1);
+
+        if (args.offsets != nullptr)
+        {
+            p = _mm256_sub_ps(p, gatherPoints(args.offsets, o0, o1));
+        }
+
+        // Each coordinate is broadcast across its point and scales a column.
+        __m256 m = _mm256_add_ps(translation, _mm256_mul_ps(column0, _mm256_permute_ps(p, 0x00)));
+        m = _mm256_add_ps(m, _mm256_mul_ps(column1, _mm256_permute_ps(p, 0x55)));
+        p = _mm256_add_ps(m, _mm256_mul_ps(column2, _mm256_permute_ps(p, 0xAA)));
+
+        if (args.add != nullptr)
+        {
+            p = _mm256_add_ps(p, _mm256_loadu_ps(args.add + 4 * i));
+        }
+
+        if (args.subtract != nullptr)
+        {
+            p = _mm256_sub_ps(p, _mm256_loadu_ps(args.subtract + 4 * i));
+        }
+
+        // The w of every output point is 1.
+        _mm256_storeu_ps(args.out + 4 * i, _mm256_blend_ps(p, w, 0x88));
+    }
+
+    PointRemap::remapScalar(args, i, end);
+}
+
+#else
+
+void PointRemap::remapAvx2(const PointRemapArgs &args, int begin, int end)
+{
+    PointRemap::remapScalar(args, begin, end);
+}
+
+#endif
+
+/*
+    Returns true if the CPU and the OS support AVX2.
+*/
+bool PointRemap::hasAvx2()
+{
+#if defined(POINT_REMAP_AVX2) && defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 1);
+
+    bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+    bool hasAvx = (info[2] & (1 << 28)) != 0;
+
+    if (!hasOsxsave || !hasAvx || (_xgetbv(0) & 6) != 6) { return false; }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(POINT_REMAP_AVX2)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/*
+    The points of an MFloatPointArray as a float buffer. MFloatPoint is four 
+    floats, and the array stores them contiguously.
+*/
+const float* PointRemap::data(const MFloatPointArray &points)
+{
+    return points.length() == 0 ? nullptr : &points[0].x;
+}
+
+float* PointRemap::data(MFloatPointArray &points)
+{
+    return points.length() == 0 ? nullptr : &points[0].x;
+}
\ No newline at end of file
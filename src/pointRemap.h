@@ -0,0 +1,68 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_POINT_REMAP_H
+#define POLY_SYMMETRY_POINT_REMAP_H
+
+#include <maya/MFloatPointArray.h>
+
+// Meshes with fewer points are remapped on the calling thread.
+#define POINT_REMAP_PARALLEL_THRESHOLD 65536
+#define POINT_REMAP_CHUNK_SIZE 16384
+
+using namespace std;
+
+/*
+    The inputs of PointRemap::remap. Point buffers are MFloatPoint arrays -
+    four floats per point - and every one except points may be null. For 
+    each point i, with o = symmetry[i]:
+
+        out[i] = M * (points[o] - offsets[o]) + add[i] - subtract[i]
+
+    where M is an affine transform - a 3x3 matrix in the first three columns
+    and a translation in the last. The default negates x. A symmetry index
+    outside the buffers maps the point to itself. out must not be one of 
+    the other buffers.
+*/
+struct PointRemapArgs
+{
+    const float*        points = nullptr;
+    const float*        offsets = nullptr;
+    const float*        add = nullptr;
+    const float*        subtract = nullptr;
+    const int*          symmetry = nullptr;
+
+    float               matrix[3][4] = {
+                            {-1.0f, 0.0f, 0.0f, 0.0f},
+                            { 0.0f, 1.0f, 0.0f, 0.0f},
+                            { 0.0f, 0.0f, 1.0f, 0.0f}
+                        };
+
+    int                 numberOfPoints = 0;
+    float*              out = nullptr;
+};
+
+/*
+    Moves mesh points through a symmetry table in one pass - the gather, the 
+    mirror and the delta are fused - for polyFlip and polyMirror. Uses AVX2 
+    if the CPU has it, and the thread pool for large meshes.
+*/
+class PointRemap
+{
+public:
+    static void         remap(const PointRemapArgs &args);
+    static void         remap(const PointRemapArgs &args, int begin, int end);
+
+    static bool         hasAvx2();
+
+    static const float* data(const MFloatPointArray &points);
+    static float*       data(MFloatPointArray &points);
+
+private:
+    static void         remapScalar(const PointRemapArgs &args, int begin, int end);
+    static void         remapAvx2(const PointRemapArgs &args, int begin, int end);
+};
+
+#endif
\ No newline at end of file
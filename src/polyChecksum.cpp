@@ -5,7 +5,153 @@
 
 #include "polyChecksum.h"
 
-PolyChecksum::PolyChecksum()
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define POLY_CHECKSUM_SSE42
+#include <nmmintrin.h>
+#endif
+
+#if defined(POLY_CHECKSUM_SSE42) && !defined(_MSC_VER)
+#define SSE42_FUNCTION __attribute__((target("sse4.2")))
+#else
+#define SSE42_FUNCTION
+#endif
+
+static const uint64_t XXHASH_PRIME_1 = 11400714785074694791ULL;
+static const uint64_t XXHASH_PRIME_2 = 14029467366897019727ULL;
+static const uint64_t XXHASH_PRIME_3 = 1609587929392839161ULL;
+static const uint64_t XXHASH_PRIME_4 = 9650029242287828579ULL;
+static const uint64_t XXHASH_PRIME_5 = 2870177450012600261ULL;
+
+/*
+    Tables for the legacy CRC, eight bytes at a time. Table k gives the CRC 
+    of a byte followed by k zero bytes.
+*/
+struct SlicingTables
+{
+    uint32_t table[8][256];
+
+    SlicingTables()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t reg = i << 24;
+
+            for (int j = 0; j < 8; j++)
+            {
+                reg = (reg & 0x80000000) ? (reg << 1) ^ 0x04c11db7 : (reg << 1);
+            }
+
+            table[0][i] = reg;
+        }
+
+        for (int k = 1; k < 8; k++)
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                uint32_t reg = table[k - 1][i];
+                table[k][i] = (reg << 8) ^ table[0][reg >> 24];
+            }
+        }
+    }
+};
+
+/*
+    Table for CRC32C when the CPU does not have the crc32 instruction.
+*/
+struct Crc32cTable
+{
+    uint32_t table[256];
+
+    Crc32cTable()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t reg = i;
+
+            for (int j = 0; j < 8; j++)
+            {
+                reg = (reg & 1) ? (reg >> 1) ^ 0x82f63b78 : (reg >> 1);
+            }
+
+            table[i] = reg;
+        }
+    }
+};
+
+static const SlicingTables& getSlicingTables()
+{
+    static SlicingTables tables;
+    return tables;
+}
+
+static const Crc32cTable& getCrc32cTable()
+{
+    static Crc32cTable table;
+    return table;
+}
+
+static uint32_t readUint32(const unsigned char* bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t readUint64(const unsigned char* bytes)
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t xxHashRound(uint64_t lane, uint64_t input)
+{
+    lane += input * XXHASH_PRIME_2;
+    lane = rotateLeft(lane, 31);
+    return lane * XXHASH_PRIME_1;
+}
+
+static uint64_t xxHashMergeRound(uint64_t hash, uint64_t lane)
+{
+    hash ^= xxHashRound(0, lane);
+    return hash * XXHASH_PRIME_1 + XXHASH_PRIME_4;
+}
+
+#if defined(POLY_CHECKSUM_SSE42)
+SSE42_FUNCTION static uint32_t crc32cHardware(uint32_t crc, const unsigned char* bytes, size_t dataSize)
+{
+    uint64_t crc64 = crc;
+
+    for (; dataSize >= 8; bytes += 8, dataSize -= 8)
+    {
+        crc64 = _mm_crc32_u64(crc64, readUint64(bytes));
+    }
+
+    crc = (uint32_t) crc64;
+
+    for (; dataSize > 0; bytes++, dataSize--)
+    {
+        crc = _mm_crc32_u8(crc, *bytes);
+    }
+
+    return crc;
+}
+#endif
+
+PolyChecksum::PolyChecksum(ChecksumAlgorithm algorithm)
 {
 	// for all possible byte values
 	for (unsigned i = 0; i < 256; ++i)
@@ -22,15 +168,33 @@ PolyChecksum::PolyChecksum()
 		}
 		_table [i] = reg;
 	}
+
+    this->algorithm = algorithm;
+
+    lanes[0] = XXHASH_PRIME_1 + XXHASH_PRIME_2;
+    lanes[1] = XXHASH_PRIME_2;
+    lanes[2] = 0;
+    lanes[3] = 0 - XXHASH_PRIME_1;
 }
 
 void PolyChecksum::putBytes(void* bytes, size_t dataSize)
 {
-    unsigned char* ptr = (unsigned char*) bytes;
+    const unsigned char* ptr = (const unsigned char*) bytes;
+
+    switch (algorithm)
+    {
+        case kSlicingChecksum:  this->putBytesSlicing(ptr, dataSize); break;
+        case kCrc32cChecksum:   this->putBytesCrc32c(ptr, dataSize); break;
+        case kXxHash64Checksum: this->putBytesXxHash64(ptr, dataSize); break;
+        default:                this->putBytesLegacy(ptr, dataSize); break;
+    }
+}
 
+void PolyChecksum::putBytesLegacy(const unsigned char* bytes, size_t dataSize)
+{
     for (size_t i = 0; i < dataSize; i++)
     {
-        unsigned byte = *(ptr + i);
+        unsigned byte = *(bytes + i);
         unsigned top = _register >> 24;
         top ^= byte;
         top &= 255;
@@ -39,7 +203,174 @@ void PolyChecksum::putBytes(void* bytes, size_t dataSize)
     }
 }
 
+/*
+    Same CRC as putBytesLegacy. Only the low 32 bits of the legacy register 
+    ever reach the result, so the register is kept at 32 bits here.
+*/
+void PolyChecksum::putBytesSlicing(const unsigned char* bytes, size_t dataSize)
+{
+    const SlicingTables &tables = getSlicingTables();
+
+    uint32_t reg = (uint32_t) _register;
+
+    for (; dataSize >= 8; bytes += 8, dataSize -= 8)
+    {
+        reg ^= ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | (uint32_t) bytes[3];
+
+        reg = tables.table[7][reg >> 24]
+            ^ tables.table[6][(reg >> 16) & 255]
+            ^ tables.table[5][(reg >> 8) & 255]
+            ^ tables.table[4][reg & 255]
+            ^ tables.table[3][bytes[4]]
+            ^ tables.table[2][bytes[5]]
+            ^ tables.table[1][bytes[6]]
+            ^ tables.table[0][bytes[7]];
+    }
+
+    for (; dataSize > 0; bytes++, dataSize--)
+    {
+        reg = (reg << 8) ^ tables.table[0][(reg >> 24) ^ *bytes];
+    }
+
+    _register = reg;
+}
+
+void PolyChecksum::putBytesCrc32c(const unsigned char* bytes, size_t dataSize)
+{
+#if defined(POLY_CHECKSUM_SSE42)
+    static const bool hasHardware = PolyChecksum::hasHardwareCrc32c();
+
+    if (hasHardware)
+    {
+        crc32c = crc32cHardware(crc32c, bytes, dataSize);
+        return;
+    }
+#endif
+
+    const Crc32cTable &table = getCrc32cTable();
+
+    for (; dataSize > 0; bytes++, dataSize--)
+    {
+        crc32c = (crc32c >> 8) ^ table.table[(crc32c ^ *bytes) & 255];
+    }
+}
+
+void PolyChecksum::putBytesXxHash64(const unsigned char* bytes, size_t dataSize)
+{
+    totalSize += dataSize;
+
+    if (stripeSize + dataSize < 32)
+    {
+        memcpy(stripe + stripeSize, bytes, dataSize);
+        stripeSize += dataSize;
+        return;
+    }
+
+    if (stripeSize > 0)
+    {
+        size_t fill = 32 - stripeSize;
+        memcpy(stripe + stripeSize, bytes, fill);
+
+        for (int i = 0; i < 4; i++)
+        {
+            lanes[i] = xxHashRound(lanes[i], readUint64(stripe + i * 8));
+        }
+
+        bytes += fill;
+        dataSize -= fill;
+        stripeSize = 0;
+    }
+
+    for (; dataSize >= 32; bytes += 32, dataSize -= 32)
+    {
+        lanes[0] = xxHashRound(lanes[0], readUint64(bytes));
+        lanes[1] = xxHashRound(lanes[1], readUint64(bytes + 8));
+        lanes[2] = xxHashRound(lanes[2], readUint64(bytes + 16));
+        lanes[3] = xxHashRound(lanes[3], readUint64(bytes + 24));
+    }
+
+    memcpy(stripe, bytes, dataSize);
+    stripeSize = dataSize;
+}
+
 int PolyChecksum::getResult()
 {
-    return (int) this->_register;
+    return (int) this->getResult64();
+}
+
+uint64_t PolyChecksum::getResult64()
+{
+    if (algorithm == kCrc32cChecksum)
+    {
+        return ~crc32c;
+    }
+
+    if (algorithm != kXxHash64Checksum)
+    {
+        return (uint32_t) this->_register;
+    }
+
+    uint64_t hash;
+
+    if (totalSize >= 32)
+    {
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+
+        for (int i = 0; i < 4; i++)
+        {
+            hash = xxHashMergeRound(hash, lanes[i]);
+        }
+    } else {
+        hash = lanes[2] + XXHASH_PRIME_5;
+    }
+
+    hash += totalSize;
+
+    const unsigned char* bytes = stripe;
+    size_t dataSize = stripeSize;
+
+    for (; dataSize >= 8; bytes += 8, dataSize -= 8)
+    {
+        hash ^= xxHashRound(0, readUint64(bytes));
+        hash = rotateLeft(hash, 27) * XXHASH_PRIME_1 + XXHASH_PRIME_4;
+    }
+
+    if (dataSize >= 4)
+    {
+        hash ^= (uint64_t) readUint32(bytes) * XXHASH_PRIME_1;
+        hash = rotateLeft(hash, 23) * XXHASH_PRIME_2 + XXHASH_PRIME_3;
+
+        bytes += 4;
+        dataSize -= 4;
+    }
+
+    for (; dataSize > 0; bytes++, dataSize--)
+    {
+        hash ^= *bytes * XXHASH_PRIME_5;
+        hash = rotateLeft(hash, 11) * XXHASH_PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXHASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= XXHASH_PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/*
+    Returns true if the CPU has the SSE4.2 crc32 instruction.
+*/
+bool PolyChecksum::hasHardwareCrc32c()
+{
+#if defined(POLY_CHECKSUM_SSE42) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#elif defined(POLY_CHECKSUM_SSE42)
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
 }
@@ -7,20 +7,62 @@
 #define POLY_CHECKSUM_H
 
 #include <cstddef>
+#include <cstdint>
 
 // based on code found at http://www.relisoft.com/science/CrcOptim.html
 
+/*
+    Hashing backends for PolyChecksum. The legacy and slicing backends compute 
+    the same CRC, so either one matches the vertexChecksum stored on existing 
+    polySymmetryData nodes. The other two give different values.
+*/
+enum ChecksumAlgorithm
+{
+    // The original CRC, one byte at a time.
+    kLegacyChecksum = 0,
+    
+    // The original CRC, eight bytes at a time with slicing-by-8 tables.
+    kSlicingChecksum,
+
+    // CRC32C, with the SSE4.2 crc32 instruction if the CPU has it.
+    kCrc32cChecksum,
+
+    // 64-bit xxHash.
+    kXxHash64Checksum
+};
+
 class PolyChecksum
 {
 public:
-                        PolyChecksum();
+                        PolyChecksum(ChecksumAlgorithm algorithm=kLegacyChecksum);
     virtual void        putBytes(void* bytes, size_t dataSize);
     virtual int         getResult();
+    virtual uint64_t    getResult64();
+
+    static bool         hasHardwareCrc32c();
+
+private:
+    void                putBytesLegacy(const unsigned char* bytes, size_t dataSize);
+    void                putBytesSlicing(const unsigned char* bytes, size_t dataSize);
+    void                putBytesCrc32c(const unsigned char* bytes, size_t dataSize);
+    void                putBytesXxHash64(const unsigned char* bytes, size_t dataSize);
 
 public:
 	unsigned long       _table[256];
 	unsigned long       _register = 0;
 	unsigned long       _key = 0x04c11db7;
+
+private:
+    ChecksumAlgorithm   algorithm;
+
+    uint32_t            crc32c = 0xFFFFFFFF;
+
+    // xxHash64 state - four lanes, the bytes that do not fill a 32 byte 
+    // stripe yet, and the total length.
+    uint64_t            lanes[4];
+    unsigned char       stripe[32];
+    size_t              stripeSize = 0;
+    uint64_t            totalSize = 0;
 };
 
 #endif
@@ -4,15 +4,22 @@
 */
 
 #include "meshData.h"
+#include "polyChecksum.h"
 #include "polyChecksumCommand.h"
+#include "sceneCache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
 
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
 #include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
-#include <maya/MItMeshVertex.h>
 #include <maya/MIntArray.h>
+#include <maya/MItMeshVertex.h>
 #include <maya/MPxCommand.h>
 #include <maya/MSelectionList.h>
 #include <maya/MString.h>
@@ -33,12 +40,17 @@ MSyntax PolyChecksumCommand::getSyntax()
 {
     MSyntax syntax;
 
-    syntax.setObjectType(MSyntax::kSelectionList, 1, 1);
+    syntax.setObjectType(MSyntax::kSelectionList, 0, 1);
     syntax.useSelectionAsDefault(true);
 
     syntax.enableQuery(false);
     syntax.enableEdit(false);
 
+    syntax.addFlag(CHECKSUM_VERSION_FLAG, CHECKSUM_VERSION_LONG_FLAG, MSyntax::kLong);
+    syntax.addFlag(ALGORITHM_FLAG, ALGORITHM_LONG_FLAG, MSyntax::kString);
+    syntax.addFlag(BENCHMARK_FLAG, BENCHMARK_LONG_FLAG);
+    syntax.addFlag(CACHE_STATISTICS_FLAG, CACHE_STATISTICS_LONG_FLAG);
+
     return syntax;
 }
 
@@ -47,6 +59,17 @@ MStatus PolyChecksumCommand::doIt(const MArgList& argList)
     MStatus status;
     MArgDatabase argsData(syntax(), argList);
 
+    // Reports how often symmetry lookups reused a memoized mesh checksum.
+    if (argsData.isFlagSet(CACHE_STATISTICS_FLAG))
+    {
+        MIntArray result;
+        result.append((int) PolySymmetryCache::checksumHits);
+        result.append((int) PolySymmetryCache::checksumMisses);
+
+        this->setResult(result);
+        return MStatus::kSuccess;
+    }
+
     MSelectionList selection;
     argsData.getObjects(selection);
 
@@ -58,13 +81,148 @@ MStatus PolyChecksumCommand::doIt(const MArgList& argList)
         return MStatus::kFailure;
     }
 
+    if (argsData.isFlagSet(CHECKSUM_VERSION_FLAG))
+    {
+        int checksumVersion = argsData.flagArgumentInt(CHECKSUM_VERSION_FLAG, 0);
+
+        if (checksumVersion != kVertexRingChecksum && checksumVersion != kTopologyChecksum)
+        {
+            MString errorMsg("Unknown checksum version ^1s. Must be 0 (vertex rings) or 1 (topology).");
+            MString versionString;
+            versionString += checksumVersion;
+
+            errorMsg.format(errorMsg, versionString);
+            MGlobal::displayError(errorMsg);
+            return MStatus::kFailure;
+        }
+
+        this->checksumVersion = (ChecksumVersion) checksumVersion;
+    }
+
+    // Without -algorithm the result is the value a polySymmetryData node 
+    // stores for this checksum version.
+    this->algorithm = MeshData::getChecksumAlgorithm(this->checksumVersion);
+
+    if (argsData.isFlagSet(ALGORITHM_FLAG))
+    {
+        MString algorithmName = argsData.flagArgumentString(ALGORITHM_FLAG, 0);
+
+        if (!getAlgorithm(algorithmName, this->algorithm))
+        {
+            MGlobal::displayError("Unknown checksum algorithm \"" + algorithmName + "\". Must be one of legacy, crc32, crc32c or xxhash64.");
+            return MStatus::kFailure;
+        }
+    }
+
+    this->hexResult = this->algorithm == kXxHash64Checksum;
+
+    this->benchmark = argsData.isFlagSet(BENCHMARK_FLAG);
+
     return this->redoIt();
 }
 
 MStatus PolyChecksumCommand::redoIt()
 {
-    unsigned long checksum = MeshData::getVertexChecksum(this->mesh);
-	this->setResult((int) checksum);
+    if (this->benchmark)
+    {
+        return this->runBenchmark();
+    }
+
+    uint64_t checksum = MeshData::getVertexChecksum(this->mesh, this->checksumVersion, this->algorithm);
+
+    // A 64-bit hash does not fit in an int result, so xxhash64 is returned 
+    // in full as hex.
+    if (this->hexResult)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) checksum);
+
+        this->setResult(MString(hex));
+    } else {
+    	this->setResult((int) checksum);
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Hashes the vertex checksum data of the mesh with each backend, and 
+    returns the throughput of each in MB/s.
+*/
+MStatus PolyChecksumCommand::runBenchmark()
+{
+    const char* algorithmNames[] = {"legacy", "crc32", "crc32c", "xxhash64"};
+
+    vector<int> data;
+
+    auto gatherStartTime = chrono::steady_clock::now();
+    MeshData::getVertexChecksumData(this->mesh, this->checksumVersion, data);
+    double gatherSeconds = chrono::duration<double>(chrono::steady_clock::now() - gatherStartTime).count();
+
+    MString gatherMsg("polyChecksum: read ^1s bytes of checksum data in ^2s ms");
+    MString gatherSize;
+    MString gatherTime;
+    gatherSize += (int) (data.size() * sizeof(int));
+    gatherTime += gatherSeconds * 1000.0;
+
+    gatherMsg.format(gatherMsg, gatherSize, gatherTime);
+    MGlobal::displayInfo(gatherMsg);
+
+    size_t dataSize = data.size() * sizeof(int);
+
+    if (dataSize == 0) 
+    { 
+        return MStatus::kSuccess; 
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        ChecksumAlgorithm algorithm = (ChecksumAlgorithm) i;
+
+        int numberOfRuns = 0;
+        double seconds = 0.0;
+        uint64_t result = 0;
+
+        // Small meshes are hashed many times, so the timing is not just noise.
+        auto startTime = chrono::steady_clock::now();
+
+        while (numberOfRuns == 0 || seconds < 0.25)
+        {
+            PolyChecksum checksum(algorithm);
+            checksum.putBytes(data.data(), dataSize);
+            result ^= checksum.getResult64();
+
+            numberOfRuns++;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        }
+
+        double megabytesPerSecond = (double) dataSize * numberOfRuns / seconds / (1024.0 * 1024.0);
+
+        MString infoMsg("polyChecksum: ^1s ^2s MB/s");
+        MString throughput;
+        throughput += megabytesPerSecond;
+
+        infoMsg.format(infoMsg, MString(algorithmNames[i]), throughput);
+
+        if (algorithm == kCrc32cChecksum)
+        {
+            infoMsg += PolyChecksum::hasHardwareCrc32c() ? " (SSE4.2)" : " (software)";
+        }
+
+        MGlobal::displayInfo(infoMsg);
+
+        this->appendToResult(megabytesPerSecond);
+    }
 
     return MStatus::kSuccess;
+}
+
+bool PolyChecksumCommand::getAlgorithm(const MString &name, ChecksumAlgorithm &algorithm)
+{
+    if (name == "legacy")   { algorithm = kLegacyChecksum; return true; }
+    if (name == "crc32")    { algorithm = kSlicingChecksum; return true; }
+    if (name == "crc32c")   { algorithm = kCrc32cChecksum; return true; }
+    if (name == "xxhash64") { algorithm = kXxHash64Checksum; return true; }
+
+    return false;
 }
\ No newline at end of file
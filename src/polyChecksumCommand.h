@@ -6,6 +6,9 @@
 #ifndef TOPOLOGY_CHECKSUM_COMMAND_H
 #define TOPOLOGY_CHECKSUM_COMMAND_H
 
+#include "meshData.h"
+#include "polyChecksum.h"
+
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
@@ -14,6 +17,24 @@
 #include <maya/MStatus.h>
 #include <maya/MSyntax.h>
 
+#define ALGORITHM_FLAG          "-alg"
+#define ALGORITHM_LONG_FLAG     "-algorithm"
+
+#define CHECKSUM_VERSION_FLAG       "-cv"
+#define CHECKSUM_VERSION_LONG_FLAG  "-checksumVersion"
+
+#define CACHE_STATISTICS_FLAG       "-cs"
+#define CACHE_STATISTICS_LONG_FLAG  "-cacheStatistics"
+
+#define BENCHMARK_FLAG          "-bm"
+#define BENCHMARK_LONG_FLAG     "-benchmark"
+
+/*
+    Returns the vertex checksum of a mesh. By default this is the topology 
+    checksum, an xxhash64 returned as a 16-digit hex string. Earlier versions
+    returned the legacy CRC as an int by default; -checksumVersion 0 still
+    returns that value, which is what older polySymmetryData nodes store.
+*/
 class PolyChecksumCommand : public MPxCommand
 {
 public:
@@ -26,6 +47,10 @@ public:
     virtual MStatus     doIt(const MArgList& argList);
     virtual MStatus     redoIt();
 
+    virtual MStatus     runBenchmark();
+
+    static bool         getAlgorithm(const MString &name, ChecksumAlgorithm &algorithm);
+
     virtual bool        isUndoable() const { return false; }
     virtual bool        hasSyntax()  const { return true; }
     
@@ -34,6 +59,11 @@ public:
 
 private:    
     MDagPath            mesh;
+
+    ChecksumVersion     checksumVersion = kTopologyChecksum;
+    ChecksumAlgorithm   algorithm = kXxHash64Checksum;
+    bool                hexResult = false;
+    bool                benchmark = false;
 };
 
 #endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "parseArgs.h"
 #include "polyDeformerWeights.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 #include "selection.h"
 
@@ -201,7 +202,7 @@ MStatus PolyDeformerWeightsCommand::validateArguments()
 
     if (mirrorWeights || flipWeights)
     {
-        bool cacheHit = PolySymmetryCache::getNodeFromCache(this->sourceMesh, this->polySymmetryData);
+        bool cacheHit = PolySymmetryCache::getMeshTables(this->sourceMesh, this->tablesData, this->tables);
 
         if (!cacheHit)
         {
@@ -287,13 +288,8 @@ MStatus PolyDeformerWeightsCommand::redoIt()
 
     if (mirrorWeights || flipWeights)
     {
-        vector<int> vertexSymmetry;
-        vector<int> vertexSides;
-
-        MFnDependencyNode fnNode(polySymmetryData);
-
-        PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
-        PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, vertexSides);
+        const int* vertexSymmetry = tables->vertexSymmetry();
+        const int8_t* vertexSides = tables->vertexSides();
 
         MItGeometry itGeo(destinationMesh, components);
 
@@ -326,7 +322,7 @@ MStatus PolyDeformerWeightsCommand::redoIt()
     return MStatus::kSuccess;    
 }
 
-float PolyDeformerWeightsCommand::getWeight(int vertexIndex, MFloatArray &sourceWeights, vector<int> &vertexSymmetry, vector<int> vertexSides)
+float PolyDeformerWeightsCommand::getWeight(int vertexIndex, MFloatArray &sourceWeights, const int* vertexSymmetry, const int8_t* vertexSides)
 {
     int i = vertexIndex;
     int o = vertexSymmetry[i];
@@ -6,6 +6,8 @@
 #ifndef POLY_DEFORMER_WEIGHTS_H
 #define POLY_DEFORMER_WEIGHTS_H
 
+#include "polySymmetryTables.h"
+
 #include <vector>
 
 #include <maya/MArgList.h>
@@ -36,7 +38,7 @@ public:
     virtual MStatus     redoIt();
     virtual MStatus     undoIt();
 
-    virtual float       getWeight(int vertexIndex, MFloatArray &sourceWeights, vector<int> &vertexSymmetry, vector<int> vertexSides);
+    virtual float       getWeight(int vertexIndex, MFloatArray &sourceWeights, const int* vertexSymmetry, const int8_t* vertexSides);
 
     virtual bool        isUndoable() const { return true; }
     virtual bool        hasSyntax()  const { return true; }
@@ -56,7 +58,8 @@ private:
     MDagPath            sourceMesh;
     MDagPath            destinationMesh;
 
-    MObject             polySymmetryData;
+    MObject             tablesData;
+    const PolySymmetryTables* tables = nullptr;
 
     MObject             sourceDeformer;
     MObject             destinationDeformer;
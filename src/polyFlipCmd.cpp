@@ -5,20 +5,22 @@
 
 #include <vector>
 
+#include "mirrorPlane.h"
+#include "parseArgs.h"
+#include "pointRemap.h"
 #include "polyFlipCmd.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
 #include <maya/MFnDependencyNode.h>
+#include <maya/MFloatPointArray.h>
 #include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
-#include <maya/MItGeometry.h>
 #include <maya/MIntArray.h>
-#include <maya/MPoint.h>
-#include <maya/MPointArray.h>
 #include <maya/MPxCommand.h>
 #include <maya/MSelectionList.h>
 #include <maya/MString.h>
@@ -55,6 +57,8 @@ MSyntax PolyFlipCommand::getSyntax()
     syntax.addFlag(OBJECT_SPACE_FLAG, OBJECT_SPACE_LONG_FLAG);
     syntax.addFlag(REFERENCE_MESH_FLAG, REFERENCE_MESH_LONG_FLAG, MSyntax::kSelectionItem);
 
+    MirrorPlane::addFlags(syntax);
+
     syntax.enableQuery(false);
     syntax.enableEdit(false);
 
@@ -78,7 +82,7 @@ MStatus PolyFlipCommand::doIt(const MArgList& argList)
         return MStatus::kFailure;
     }
     
-    bool cacheHit = PolySymmetryCache::getNodeFromCache(this->selectedMesh, this->polySymmetryData);
+    bool cacheHit = PolySymmetryCache::getMeshTables(this->selectedMesh, this->tablesData, this->tables);
 
     if (!cacheHit)
     {
@@ -97,20 +101,19 @@ MStatus PolyFlipCommand::doIt(const MArgList& argList)
 
     if (argsData.isFlagSet(OBJECT_SPACE_FLAG))
     {
-        this->worldSpace = true;
+        this->worldSpace = false;
     }
 
+    status = this->mirrorPlane.parseArguments(argsData);
+    if (!status) { return status; }
+
     if (argsData.isFlagSet(REFERENCE_MESH_FLAG))
     {
-        MSelectionList referenceMeshSelection;
-
-        argsData.getObjects(referenceMeshSelection);
-
-        status = referenceMeshSelection.getDagPath(0, this->referenceMesh);
+        parseArgs::getDagPathArgument(argsData, REFERENCE_MESH_FLAG, this->referenceMesh, false);
         
-        if (!status || !this->referenceMesh.hasFn(MFn::kMesh))
+        if (!parseArgs::isNodeType(this->referenceMesh, MFn::kMesh))
         {
-            MString errorMsg("%s flag requires a mesh.");
+            MString errorMsg("^1s flag requires a mesh.");
             errorMsg.format(errorMsg, MString(REFERENCE_MESH_LONG_FLAG));
 
             MGlobal::displayError(errorMsg);
@@ -137,13 +140,11 @@ MStatus PolyFlipCommand::doIt(const MArgList& argList)
 
 MStatus PolyFlipCommand::redoIt()
 {
-    if (this->worldSpace || this->objectSpace)
+    if (this->referenceMesh.isValid())
     {
-        return this->flipMesh();
-    } else if (this->referenceMesh.isValid()) {
         return this->flipMeshAgainst();
     } else {
-        return MStatus::kSuccess;
+        return this->flipMesh();
     }
 }
 
@@ -154,32 +155,35 @@ MStatus PolyFlipCommand::flipMesh()
 
     MSpace::Space space = this->worldSpace ? MSpace::kWorld : MSpace::kObject;
 
-    vector<int> vertexSymmetry;
-    vector<int> vertexSides;
+    MFnMesh fnMesh(this->selectedMesh);
 
-    MFnDependencyNode fnNode(this->polySymmetryData);
+    status = this->getOriginalPoints(fnMesh, tables);
+    if (!status) { return status; }
 
-    PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, vertexSides);
+    MFloatPointArray worldPoints;
 
-    MFnMesh fnMesh(this->selectedMesh);
-    MItGeometry itGeo(this->selectedMesh);
-    itGeo.allPositions(this->originalPoints, space);
+    if (space == MSpace::kWorld)
+    {
+        fnMesh.getPoints(worldPoints, space);
+    }
 
-    uint numberOfVertices = fnMesh.numVertices();
-    MPointArray newPoints(numberOfVertices);
+    const MFloatPointArray &points = space == MSpace::kWorld ? worldPoints : this->originalPoints;
+    MFloatPointArray newPoints(points.length());
 
-    MPoint pnt;
+    MirrorPlane plane = this->mirrorPlane;
+    plane.setSpace(this->selectedMesh, space);
+    plane.checkCenterVertices(points, tables->vertexSides(), this->selectedMesh, true);
 
-    for (uint i = 0; i < numberOfVertices; i++)
-    {
-        int o = vertexSymmetry[i];
-        pnt = this->originalPoints[o];
+    PointRemapArgs args;
+    plane.getReflection(args.matrix);
+    args.points = PointRemap::data(points);
+    args.symmetry = tables->vertexSymmetry();
+    args.numberOfPoints = (int) points.length();
+    args.out = PointRemap::data(newPoints);
 
-        newPoints.set(i, pnt.x * -1.0, pnt.y, pnt.z);
-    }
+    PointRemap::remap(args);
 
-    itGeo.setAllPositions(newPoints, space);
+    fnMesh.setPoints(newPoints, space);
 
     return MStatus::kSuccess;
 }
@@ -190,55 +194,66 @@ MStatus PolyFlipCommand::flipMeshAgainst()
 
     MSpace::Space space = this->worldSpace ? MSpace::kWorld : MSpace::kObject;
 
-    vector<int> vertexSymmetry;
-    vector<int> vertexSides;
+    MFnMesh fnMesh(this->selectedMesh);
+    MFnMesh fnReference(this->referenceMesh);
 
-    MPointArray referencePoints;
-    MFnDependencyNode fnNode(this->polySymmetryData);
+    status = this->getOriginalPoints(fnMesh, tables);
+    if (!status) { return status; }
 
-    PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, vertexSides);
+    MFloatPointArray worldPoints;
+    MFloatPointArray referencePoints;
 
-    MFnMesh fnMesh(this->selectedMesh);
+    if (space == MSpace::kWorld)
+    {
+        fnMesh.getPoints(worldPoints, space);
+    }
 
-    MItGeometry itRef(this->referenceMesh);
-    MItGeometry itGeo(this->selectedMesh);
+    fnReference.getPoints(referencePoints, space);
 
-    itRef.allPositions(referencePoints, space);
-    itGeo.allPositions(this->originalPoints, space);
+    const MFloatPointArray &points = space == MSpace::kWorld ? worldPoints : this->originalPoints;
+    MFloatPointArray newPoints(points.length());
 
-    uint numberOfVertices = fnMesh.numVertices();
-    MPointArray newPoints(numberOfVertices);
+    // Only the orientation of the plane matters here - the offsets are 
+    // reflected, not the points.
+    MirrorPlane plane = this->mirrorPlane;
+    plane.setSpace(this->selectedMesh, space);
+    plane.checkCenterVertices(referencePoints, tables->vertexSides(), this->referenceMesh, false);
 
-    MPoint pnt;
-    MPoint ref;
-    MVector delta;
+    // Each point moves from the reference by the mirrored offset of its 
+    // mirror from the reference.
+    PointRemapArgs args;
+    plane.getLinearReflection(args.matrix);
+    args.points = PointRemap::data(points);
+    args.offsets = PointRemap::data(referencePoints);
+    args.add = PointRemap::data(referencePoints);
+    args.symmetry = tables->vertexSymmetry();
+    args.numberOfPoints = (int) points.length();
+    args.out = PointRemap::data(newPoints);
 
-    for (uint i = 0; i < numberOfVertices; i++)
-    {
-        if (vertexSides[i] == 0)
-        {
-            newPoints.set(this->originalPoints[i], i);
-        }
+    PointRemap::remap(args);
+
+    fnMesh.setPoints(newPoints, space);
 
-        int o = vertexSymmetry[i];
-        pnt = this->originalPoints[o];
-        ref = referencePoints[o];
+    return MStatus::kSuccess;
+}
 
-        delta = pnt - ref;
+/*
+    Saves the object space points of the mesh for undo, and checks that the 
+    symmetry tables fit the mesh.
+*/
+MStatus PolyFlipCommand::getOriginalPoints(MFnMesh &fnMesh, const PolySymmetryTables* tables)
+{
+    fnMesh.getPoints(this->originalPoints, MSpace::kObject);
 
-        ref = referencePoints[i];
+    if ((int) this->originalPoints.length() != tables->numberOfVertices())
+    {
+        MString errorMsg("^1s does not have the same number of vertices as its symmetry tables.");
+        errorMsg.format(errorMsg, this->selectedMesh.partialPathName());
 
-        newPoints.set(
-            i,
-            (delta.x * -1.0) + ref.x,
-            delta.y + ref.y,
-            delta.z + ref.z
-        );
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
     }
 
-    itGeo.setAllPositions(newPoints, space);
-
     return MStatus::kSuccess;
 }
 
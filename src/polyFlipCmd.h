@@ -6,11 +6,15 @@
 #ifndef POLY_FLIP_CMD_H
 #define POLY_FLIP_CMD_H
 
+#include "mirrorPlane.h"
+#include "polySymmetryTables.h"
+
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
-#include <maya/MPoint.h>
-#include <maya/MPointArray.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MFnMesh.h>
+#include <maya/MObject.h>
 #include <maya/MPxCommand.h>
 #include <maya/MString.h>
 #include <maya/MStatus.h>
@@ -34,6 +38,8 @@ public:
     virtual MStatus     flipMesh();
     virtual MStatus     flipMeshAgainst();
 
+    virtual MStatus     getOriginalPoints(MFnMesh &fnMesh, const PolySymmetryTables* tables);
+
     virtual bool        isUndoable() const { return true; }
     virtual bool        hasSyntax()  const { return true; }
 
@@ -42,10 +48,12 @@ public:
 
 private:    
     bool                worldSpace = false;
-    bool                objectSpace = true;
 
-    MPointArray         originalPoints;
-    MObject             polySymmetryData;
+    MirrorPlane         mirrorPlane;
+
+    MFloatPointArray    originalPoints;
+    MObject             tablesData;
+    const PolySymmetryTables* tables = nullptr;
     MDagPath            selectedMesh;
     MDagPath            referenceMesh;
 };
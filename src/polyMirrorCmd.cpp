@@ -5,20 +5,27 @@
 
 #include <vector>
 
+#include "blendShapeMirror.h"
+#include "mirrorPlane.h"
+#include "parseArgs.h"
+#include "pointRemap.h"
 #include "polyMirrorCmd.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
+#include <maya/MDGModifier.h>
+#include <maya/MFnBlendShapeDeformer.h>
 #include <maya/MFnDependencyNode.h>
+#include <maya/MFloatPointArray.h>
 #include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
-#include <maya/MItGeometry.h>
 #include <maya/MIntArray.h>
-#include <maya/MPoint.h>
-#include <maya/MPointArray.h>
+#include <maya/MObjectArray.h>
+#include <maya/MPlug.h>
 #include <maya/MPxCommand.h>
 #include <maya/MSelectionList.h>
 #include <maya/MString.h>
@@ -27,6 +34,19 @@
 
 using namespace std;
 
+// Mirrors the targets of a blendShape node instead of a target mesh.
+#define BLEND_SHAPE_FLAG "-bs"
+#define BLEND_SHAPE_LONG_FLAG "-blendShape"
+
+// A target of the blendShape to mirror in place. May be used more than once.
+#define TARGET_FLAG "-t"
+#define TARGET_LONG_FLAG "-target"
+
+// A source and a destination target - the destination is replaced by the
+// mirrored source. May be used more than once.
+#define TARGET_PAIR_FLAG "-tp"
+#define TARGET_PAIR_LONG_FLAG "-targetPair"
+
 PolyMirrorCommand::PolyMirrorCommand()  {}
 PolyMirrorCommand::~PolyMirrorCommand() {}
 
@@ -39,9 +59,18 @@ MSyntax PolyMirrorCommand::getSyntax()
 {
     MSyntax syntax;
 
-    syntax.setObjectType(MSyntax::kSelectionList, 2, 2);
+    syntax.setObjectType(MSyntax::kSelectionList, 0, 2);
     syntax.useSelectionAsDefault(true);
 
+    MirrorPlane::addFlags(syntax);
+
+    syntax.addFlag(BLEND_SHAPE_FLAG, BLEND_SHAPE_LONG_FLAG, MSyntax::kSelectionItem);
+    syntax.addFlag(TARGET_FLAG, TARGET_LONG_FLAG, MSyntax::kLong);
+    syntax.addFlag(TARGET_PAIR_FLAG, TARGET_PAIR_LONG_FLAG, MSyntax::kLong, MSyntax::kLong);
+
+    syntax.makeFlagMultiUse(TARGET_FLAG);
+    syntax.makeFlagMultiUse(TARGET_PAIR_FLAG);
+
     syntax.enableQuery(false);
     syntax.enableEdit(false);
 
@@ -54,6 +83,17 @@ MStatus PolyMirrorCommand::doIt(const MArgList& argList)
 
     MArgDatabase argsData(syntax(), argList);
 
+    status = this->mirrorPlane.parseArguments(argsData);
+    if (!status) { return status; }
+
+    if (argsData.isFlagSet(BLEND_SHAPE_FLAG))
+    {
+        status = this->parseBlendShapeArguments(argsData);
+        if (!status) { return status; }
+
+        return this->mirrorBlendShape();
+    }
+
     MSelectionList selection;
     argsData.getObjects(selection);
 
@@ -81,7 +121,7 @@ MStatus PolyMirrorCommand::doIt(const MArgList& argList)
         return MStatus::kFailure;
     }
 
-    bool cacheHit = PolySymmetryCache::getNodeFromCache(this->targetMesh, this->polySymmetryData);
+    bool cacheHit = PolySymmetryCache::getMeshTables(this->targetMesh, this->tablesData, this->tables);
 
     if (!cacheHit)
     {
@@ -98,61 +138,301 @@ MStatus PolyMirrorCommand::doIt(const MArgList& argList)
 
 MStatus PolyMirrorCommand::redoIt()
 {
-    vector<int> vertexSymmetry;
-    vector<int> vertexSides;
+    MStatus status;
 
-    MFnDependencyNode fnNode(this->polySymmetryData);
+    if (!this->blendShape.isNull())
+    {
+        return this->blendShapeModifier.doIt();
+    }
 
-    PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, vertexSides);
+    MFnMesh fnBaseMesh(this->baseMesh);
+    MFnMesh fnTargetMesh(this->targetMesh);
 
-    MPointArray basePoints;
+    MFloatPointArray basePoints;
 
-    MItGeometry itBaseGeo(this->baseMesh);
-    MItGeometry itTargetGeo(this->targetMesh);
+    fnBaseMesh.getPoints(basePoints, MSpace::kObject);
+    fnTargetMesh.getPoints(this->originalPoints, MSpace::kObject);
 
-    itBaseGeo.allPositions(basePoints, MSpace::kObject);
-    itTargetGeo.allPositions(originalPoints, MSpace::kObject);
+    if ((int) this->originalPoints.length() != tables->numberOfVertices())
+    {
+        MString errorMsg("^1s does not have the same number of vertices as its symmetry tables.");
+        errorMsg.format(errorMsg, this->targetMesh.partialPathName());
 
-    int numberOfVertices = -1;
-    PolySymmetryNode::getValue(fnNode, NUMBER_OF_VERTICES, numberOfVertices);
-    MPointArray newPoints(numberOfVertices);
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
 
-    MPoint basePnt;
-    MPoint origPnt;
-    MPoint newPnt;
+    MFloatPointArray newPoints(this->originalPoints.length());
 
-    for (int i = 0; i < numberOfVertices; i++)
-    {
-        int o = vertexSymmetry[i];
-        newPnt = originalPoints[o];
+    MirrorPlane plane = this->mirrorPlane;
+    plane.setSpace(this->targetMesh, MSpace::kObject);
+    plane.checkCenterVertices(basePoints, tables->vertexSides(), this->baseMesh, true);
 
-        newPoints.set(i, newPnt.x * -1.0, newPnt.y, newPnt.z);
-    }
-    
-    for (int i = 0; i < numberOfVertices; i++)
-    {
-        origPnt = originalPoints[i];
-        basePnt = basePoints[i];
-        newPnt = newPoints[i];
+    // The target keeps its own offset from the base, and gains the 
+    // mirrored offset of the other side.
+    PointRemapArgs args;
+    plane.getReflection(args.matrix);
+    args.points = PointRemap::data(this->originalPoints);
+    args.add = PointRemap::data(this->originalPoints);
+    args.subtract = PointRemap::data(basePoints);
+    args.symmetry = tables->vertexSymmetry();
+    args.numberOfPoints = (int) this->originalPoints.length();
+    args.out = PointRemap::data(newPoints);
 
-        newPoints.set(
-            i, 
-            origPnt.x + newPnt.x - basePnt.x,
-            origPnt.y + newPnt.y - basePnt.y,
-            origPnt.z + newPnt.z - basePnt.z
-        );
-    }
+    PointRemap::remap(args);
 
-    itTargetGeo.setAllPositions(newPoints, MSpace::kObject);
+    fnTargetMesh.setPoints(newPoints, MSpace::kObject);
 
     return MStatus::kSuccess;
 }
 
 MStatus PolyMirrorCommand::undoIt()
 {   
+    if (!this->blendShape.isNull())
+    {
+        return this->blendShapeModifier.undoIt();
+    }
+
     MFnMesh fnMesh(this->targetMesh);
     fnMesh.setPoints(originalPoints, MSpace::kObject);
 
     return MStatus::kSuccess;
 }
+
+MStatus PolyMirrorCommand::parseBlendShapeArguments(MArgDatabase &argsData)
+{
+    MStatus status;
+
+    status = parseArgs::getNodeArgument(argsData, BLEND_SHAPE_FLAG, this->blendShape, true);
+    if (!status) { return status; }
+
+    if (!parseArgs::isNodeType(this->blendShape, MFn::kBlendShape))
+    {
+        MString errorMsg("^1s flag requires a blendShape node.");
+        errorMsg.format(errorMsg, MString(BLEND_SHAPE_LONG_FLAG));
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    MFnBlendShapeDeformer fnBlendShape(this->blendShape);
+
+    // The mesh is the selected one, or the first mesh the blendShape deforms.
+    MSelectionList selection;
+    argsData.getObjects(selection);
+
+    if (!selection.isEmpty())
+    {
+        selection.getDagPath(0, this->blendShapeMesh);
+    }
+
+    if (!parseArgs::isNodeType(this->blendShapeMesh, MFn::kMesh))
+    {
+        MObjectArray outputGeometry;
+        fnBlendShape.getOutputGeometry(outputGeometry);
+
+        if (outputGeometry.length() != 0)
+        {
+            MDagPath::getAPathTo(outputGeometry[0], this->blendShapeMesh);
+        }
+    }
+
+    if (!parseArgs::isNodeType(this->blendShapeMesh, MFn::kMesh))
+    {
+        MString errorMsg("^1s does not deform a mesh.");
+        errorMsg.format(errorMsg, fnBlendShape.name());
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    this->blendShapeMesh.extendToShape();
+
+    MArgList args;
+
+    for (unsigned i = 0; i < argsData.numberOfFlagUses(TARGET_FLAG); i++)
+    {
+        argsData.getFlagArgumentList(TARGET_FLAG, i, args);
+        this->targets.push_back(args.asInt(0));
+    }
+
+    for (unsigned i = 0; i < argsData.numberOfFlagUses(TARGET_PAIR_FLAG); i++)
+    {
+        argsData.getFlagArgumentList(TARGET_PAIR_FLAG, i, args);
+        this->targetPairs.push_back(make_pair(args.asInt(0), args.asInt(1)));
+    }
+
+    MIntArray weightIndices;
+    fnBlendShape.weightIndexList(weightIndices);
+
+    // Without -target or -targetPair every target is mirrored in place.
+    if (this->targets.empty() && this->targetPairs.empty())
+    {
+        for (unsigned i = 0; i < weightIndices.length(); i++)
+        {
+            this->targets.push_back(weightIndices[i]);
+        }
+    }
+
+    vector<int> targetIndices(this->targets);
+
+    for (pair<int, int> &targetPair : this->targetPairs)
+    {
+        targetIndices.push_back(targetPair.first);
+        targetIndices.push_back(targetPair.second);
+    }
+
+    for (int targetIndex : targetIndices)
+    {
+        bool hasTarget = false;
+
+        for (unsigned i = 0; i < weightIndices.length() && !hasTarget; i++)
+        {
+            hasTarget = weightIndices[i] == targetIndex;
+        }
+
+        if (!hasTarget)
+        {
+            MString errorMsg("^1s does not have a target at index ^2s.");
+            errorMsg.format(errorMsg, fnBlendShape.name(), MString() + targetIndex);
+
+            MGlobal::displayError(errorMsg);
+            return MStatus::kFailure;
+        }
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Mirrors the blendShape targets in one pass. The symmetry is looked up
+    and decoded once for all of them, every inputTargetItem (including
+    in-betweens) is mirrored in parallel, and the new deltas are written
+    with one modifier so the batch is one undo.
+*/
+MStatus PolyMirrorCommand::mirrorBlendShape()
+{
+    MStatus status;
+
+    MFnBlendShapeDeformer fnBlendShape(this->blendShape);
+
+    unsigned geometryIndex = fnBlendShape.indexForOutputShape(this->blendShapeMesh.node(), &status);
+
+    if (!status)
+    {
+        MString errorMsg("^1s is not deformed by ^2s.");
+        errorMsg.format(errorMsg, this->blendShapeMesh.partialPathName(), fnBlendShape.name());
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    bool cacheHit = PolySymmetryCache::getMeshTables(this->blendShapeMesh, this->tablesData, this->tables);
+
+    if (!cacheHit)
+    {
+        MString errorMsg("^1s has not had it's symmetry computed.");
+        errorMsg.format(errorMsg, this->blendShapeMesh.partialPathName());
+
+        MGlobal::displayError(errorMsg);
+
+        return MStatus::kFailure;
+    }
+
+    MFnMesh fnMesh(this->blendShapeMesh);
+    MFloatPointArray meshPoints;
+
+    fnMesh.getPoints(meshPoints, MSpace::kObject);
+
+    if ((int) meshPoints.length() != tables->numberOfVertices())
+    {
+        MString errorMsg("^1s does not have the same number of vertices as its symmetry tables.");
+        errorMsg.format(errorMsg, this->blendShapeMesh.partialPathName());
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    // Deltas are mirrored, not points, so only the orientation of the 
+    // plane matters.
+    MirrorPlane plane = this->mirrorPlane;
+    plane.setSpace(this->blendShapeMesh, MSpace::kObject);
+    plane.checkCenterVertices(meshPoints, tables->vertexSides(), this->blendShapeMesh, false);
+
+    float matrix[3][4];
+    plane.getLinearReflection(matrix);
+
+    vector<pair<int, int>> targetPairs;
+
+    for (int targetIndex : this->targets)
+    {
+        targetPairs.push_back(make_pair(targetIndex, targetIndex));
+    }
+
+    targetPairs.insert(targetPairs.end(), this->targetPairs.begin(), this->targetPairs.end());
+
+    MPlug inputTargetGroups = fnBlendShape.findPlug("inputTarget", false)
+        .elementByLogicalIndex(geometryIndex)
+        .child(fnBlendShape.attribute("inputTargetGroup"));
+
+    MObject inputTargetItem = fnBlendShape.attribute("inputTargetItem");
+
+    vector<BlendShapeMirrorJob> jobs;
+    int numberOfLiveItems = 0;
+
+    for (pair<int, int> &targetPair : targetPairs)
+    {
+        MPlug sourceItems = inputTargetGroups.elementByLogicalIndex(targetPair.first).child(inputTargetItem);
+        MPlug destinationItems = inputTargetGroups.elementByLogicalIndex(targetPair.second).child(inputTargetItem);
+
+        MIntArray itemIndices;
+        sourceItems.getExistingArrayAttributeIndices(itemIndices);
+
+        for (unsigned i = 0; i < itemIndices.length(); i++)
+        {
+            BlendShapeMirrorJob job;
+            job.sourceItem = sourceItems.elementByLogicalIndex(itemIndices[i]);
+            job.destinationItem = destinationItems.elementByLogicalIndex(itemIndices[i]);
+            job.flip = targetPair.first != targetPair.second;
+
+            if (BlendShapeMirror::hasTargetGeometry(job.sourceItem) || BlendShapeMirror::hasTargetGeometry(job.destinationItem))
+            {
+                numberOfLiveItems++;
+                continue;
+            }
+
+            status = BlendShapeMirror::readDeltas(job.sourceItem, job.source);
+
+            if (!status)
+            {
+                MString warningMsg("^1s does not have a point for every component and was not mirrored.");
+                warningMsg.format(warningMsg, job.sourceItem.name());
+
+                MGlobal::displayWarning(warningMsg);
+                continue;
+            }
+
+            if (!job.flip && job.source.indices.empty()) { continue; }
+
+            jobs.push_back(job);
+        }
+    }
+
+    if (numberOfLiveItems != 0)
+    {
+        MString warningMsg("^1s target items of ^2s are driven by a mesh and were not mirrored.");
+        warningMsg.format(warningMsg, MString() + numberOfLiveItems, fnBlendShape.name());
+
+        MGlobal::displayWarning(warningMsg);
+    }
+
+    BlendShapeMirror::mirrorDeltas(jobs, tables->vertexSymmetry(), tables->numberOfVertices(), matrix);
+
+    for (BlendShapeMirrorJob &job : jobs)
+    {
+        status = BlendShapeMirror::writeDeltas(job.destinationItem, job.result, this->blendShapeModifier);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    return this->blendShapeModifier.doIt();
+}
@@ -6,16 +6,25 @@
 #ifndef POLY_MIRROR_COMMAND_H
 #define POLY_MIRROR_COMMAND_H
 
+#include "mirrorPlane.h"
+#include "polySymmetryTables.h"
+
+#include <utility>
+#include <vector>
+
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
-#include <maya/MPoint.h>
-#include <maya/MPointArray.h>
+#include <maya/MDGModifier.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MObject.h>
 #include <maya/MPxCommand.h>
 #include <maya/MString.h>
 #include <maya/MStatus.h>
 #include <maya/MSyntax.h>
 
+using namespace std;
+
 class PolyMirrorCommand : public MPxCommand
 {
 public:
@@ -29,6 +38,9 @@ public:
     virtual MStatus     redoIt();
     virtual MStatus     undoIt();
 
+    virtual MStatus     parseBlendShapeArguments(MArgDatabase &argsData);
+    virtual MStatus     mirrorBlendShape();
+
     virtual bool        isUndoable() const { return true; }
     virtual bool        hasSyntax()  const { return true; }
 
@@ -36,10 +48,19 @@ public:
     static MString      COMMAND_NAME;
 
 private:    
-    MPointArray         originalPoints;
-    MObject             polySymmetryData;
+    MirrorPlane         mirrorPlane;
+
+    MFloatPointArray    originalPoints;
+    MObject             tablesData;
+    const PolySymmetryTables* tables = nullptr;
 
     MDagPath            baseMesh;
     MDagPath            targetMesh;
+
+    MObject             blendShape;
+    MDagPath            blendShapeMesh;
+    vector<int>         targets;
+    vector<pair<int, int>> targetPairs;
+    MDGModifier         blendShapeModifier;
 };
 #endif 
@@ -15,6 +15,7 @@
 #include "parseArgs.h"
 #include "polySkinWeights.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 #include "selection.h"
 
@@ -346,7 +347,7 @@ MStatus PolySkinWeightsCommand::validateArguments()
     // Source/destination mesh must have polySymmetryData cached if the weights are going to be mirrored or flipped.
     if (mirrorWeights || flipWeights)
     {
-        bool cacheHit = PolySymmetryCache::getNodeFromCache(this->sourceMesh, this->polySymmetryData);
+        bool cacheHit = PolySymmetryCache::getMeshTables(this->sourceMesh, this->tablesData, this->tables);
 
         if (!cacheHit)
         {
@@ -391,12 +392,9 @@ MStatus PolySkinWeightsCommand::validateArguments()
         itGeo.next();
     }
 
-    if (!selectedVertices.isNull() && !polySymmetryData.isNull())
+    if (!selectedVertices.isNull() && this->tables != nullptr)
     {
-        vector<int> vertexSymmetry;
-
-        MFnDependencyNode fnNode(this->polySymmetryData);
-        PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
+        const int* vertexSymmetry = tables->vertexSymmetry();
 
         for (uint i = 0; i < numSelectedVertices; i++)
         {
@@ -1071,10 +1069,9 @@ void PolySkinWeightsCommand::copyWeightsTable(vector<string> &influenceKeys)
 /* Copy the weights from the old weights table indices to the opposite indices in the new weights table. */
 void PolySkinWeightsCommand::flipWeightsTable(vector<string> &influenceKeys)
 {
-    vector<int> vertexSymmetry;
+    if (this->tables == nullptr) { return; }
 
-    MFnDependencyNode fnNode(this->polySymmetryData);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
+    const int* vertexSymmetry = tables->vertexSymmetry();
 
     for (string &ii : influenceKeys)
     {        
@@ -1085,7 +1082,7 @@ void PolySkinWeightsCommand::flipWeightsTable(vector<string> &influenceKeys)
 
         for (int &i : selectedVertexIndices)
         {
-            int &o = vertexSymmetry[i];
+            const int &o = vertexSymmetry[i];
 
             newWeightsList[i] = oldWeightsList[o];
             newWeightsList[o] = oldWeightsList[i];
@@ -1097,12 +1094,10 @@ void PolySkinWeightsCommand::flipWeightsTable(vector<string> &influenceKeys)
 /* Copy the weights from the old weights table indices to the same and opposite indices in the new weights table. */
 void PolySkinWeightsCommand::mirrorWeightsTable(vector<string> &influenceKeys)
 {
-    vector<int> vertexSymmetry;
-    vector<int> vertexSides;
+    if (this->tables == nullptr) { return; }
 
-    MFnDependencyNode fnNode(this->polySymmetryData);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, vertexSymmetry);
-    PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, vertexSides);
+    const int* vertexSymmetry = tables->vertexSymmetry();
+    const int8_t* vertexSides = tables->vertexSides();
 
     vector<int> leftVertexMasks(numberOfVertices);
     vector<int> rightVertexMasks(numberOfVertices);
@@ -1123,7 +1118,7 @@ void PolySkinWeightsCommand::mirrorWeightsTable(vector<string> &influenceKeys)
 
         for (int &i : selectedVertexIndices)
         {                
-            int &o = vertexSymmetry[i];       
+            const int &o = vertexSymmetry[i];       
             newInfluenceWeights[i] = (leftVertexMasks[i] * oldInfluenceAWeights[i]) + (rightVertexMasks[i] * oldInfluenceBWeights[o]);
         }
     }
@@ -6,6 +6,8 @@
 #ifndef POLY_SKIN_WEIGHTS_H
 #define POLY_SKIN_WEIGHTS_H
 
+#include "polySymmetryTables.h"
+
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -124,7 +126,8 @@ private:
     MDagPath            sourceMesh;
     MObject             sourceSkin;
 
-    MObject             polySymmetryData;
+    MObject             tablesData;
+    const PolySymmetryTables* tables = nullptr;
 
     MObject             destinationComponents;
     MDagPath            destinationMesh;
@@ -35,162 +35,976 @@ components on the shell can have their symmetry computed thus:
 
 // TODO - unintuitive results returned if the mesh does not have a center edge loop whose vertices are symmetrical to themselves.
 
+#include "bitArray.h"
+#include "halfEdgeMesh.h"
 #include "meshData.h"
 #include "polySymmetry.h"
 #include "selection.h"
+#include "spatialGrid.h"
+#include "threadPool.h"
 #include "util.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <queue>
 #include <utility> 
 #include <vector>
 
 #include <maya/MDagPath.h>
 #include <maya/MFnMesh.h>
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
 
 using namespace std;
 
+static void groupByShell(const vector<int> &componentShells, int numberOfShells, AdjacencyList &shellComponents);
+
 
 PolySymmetryData::PolySymmetryData() 
 {
     MeshData meshData = MeshData();
 
-    examinedEdges = vector<bool>();
-    examinedFaces = vector<bool>();
-    examinedVertices = vector<bool>();
+    examined = ExaminedComponents();
+
+    vertexSymmetryIndices = vector<int>();
+    edgeSymmetryIndices = vector<int>();
+    faceSymmetryIndices = vector<int>();
+
+    vertexSides = vector<int8_t>();
+    edgeSides = vector<int8_t>();
+    faceSides = vector<int8_t>();
+
+    leftSideVertexIndices = vector<int>();
+}
+
+
+PolySymmetryData::~PolySymmetryData() 
+{
+    this->clear();
+}
+
+
+void PolySymmetryData::initialize(MDagPath &mesh) 
+{
+    meshData.unpackMesh(mesh);
+    halfEdgeMesh.build(meshData);
+    this->reset();
+}
+
+
+void PolySymmetryData::initialize(const MeshData &mesh) 
+{
+    meshData = mesh;
+    halfEdgeMesh.build(meshData);
+    this->reset();
+}
+
+
+void PolySymmetryData::clear()
+{
+    meshData.clear();
+    halfEdgeMesh.clear();
+    this->reset();
+}
+
+
+void PolySymmetryData::reset()
+{
+    examined.clear();
+    symmetricalHalfEdges.clear();
+
+    edgeSymmetryIndices.clear();
+    faceSymmetryIndices.clear();
+    vertexSymmetryIndices.clear();
+
+    edgeSides.clear();
+    faceSides.clear();
+    vertexSides.clear();
+
+    leftSideVertexIndices.clear();
+
+    examined.resize(meshData);
+
+    edgeSymmetryIndices.resize(meshData.numberOfEdges, -1);
+    faceSymmetryIndices.resize(meshData.numberOfFaces, -1);
+    vertexSymmetryIndices.resize(meshData.numberOfVertices, -1);
+
+    edgeSides.resize(meshData.numberOfEdges, -1);
+    faceSides.resize(meshData.numberOfFaces, -1);
+    vertexSides.resize(meshData.numberOfVertices, -1);
+}
+
+
+void PolySymmetryData::findSymmetricalVertices(ComponentSelection &selection)
+{
+    queue<pair<int, int>> symmetricalEdgesQueue = queue<pair<int, int>>();
+    symmetricalEdgesQueue.push(selection.edgeIndices);
+
+    if (selection.leftVertexIndex != -1) 
+    {
+        leftSideVertexIndices.push_back(selection.leftVertexIndex);
+    }
+
+    this->findFirstSymmetricalVertices(selection);
+
+    while (!symmetricalEdgesQueue.empty())
+    {
+        pair<int, int> edgePair = symmetricalEdgesQueue.front();
+        symmetricalEdgesQueue.pop();
+
+        markSymmetricalEdges(edgePair.first, edgePair.second);
+
+        pair<int, int> facesPair = getUnexaminedFaces(edgePair);
+
+        if (facesPair.first == -1 || facesPair.second == -1)
+        {
+            continue;
+        }
+
+        markSymmetricalFaces(facesPair.first, facesPair.second);
+
+        this->findSymmetricalVerticesOnFace(facesPair);
+        this->findSymmetricalEdgesOnFace(symmetricalEdgesQueue, facesPair.first);
+    }
+}
+
+
+void PolySymmetryData::findFirstSymmetricalVertices(ComponentSelection &selection)
+{
+    markSymmetricalVertices(selection.vertexIndices.first, selection.vertexIndices.second);
+    markSymmetricalFaces(selection.faceIndices.first, selection.faceIndices.second);
+    
+    int vertex0 = meshData.edgeVertices[selection.edgeIndices.first][0];
+    int vertex1 = meshData.edgeVertices[selection.edgeIndices.first][1];
+
+    int nextVertex0 = examined.vertices[vertex0] ? vertex1 : vertex0;
+
+    vertex0 = meshData.edgeVertices[selection.edgeIndices.second][0];
+    vertex1 = meshData.edgeVertices[selection.edgeIndices.second][1];
+
+    int nextVertex1 = examined.vertices[vertex0] ? vertex1 : vertex0;
+
+    markSymmetricalVertices(nextVertex0, nextVertex1);
+
+    this->findSymmetricalVerticesOnFace(selection.faceIndices);
+}
+
+
+/*
+    Same walk as findSymmetricalVertices, but on the half-edges of the mesh. 
+    Each pair of symmetrical half-edges is stepped around its faces in lockstep, 
+    then crossed to the twin half-edges on the next pair of faces.
+*/
+void PolySymmetryData::findSymmetricalVerticesByHalfEdges(ComponentSelection &selection)
+{
+    if (selection.leftVertexIndex != -1) 
+    {
+        leftSideVertexIndices.push_back(selection.leftVertexIndex);
+    }
+
+    this->walkHalfEdges(selection, examined, symmetricalHalfEdges);
+}
+
+
+/*
+    Runs the half-edge walk for each selection. Selections that seed different 
+    shells touch different components, so they are walked in parallel, each 
+    thread marking components as examined in its own copy of the examined 
+    flags. The copies are merged when every walk has finished.
+
+    With faceWalk, the selections are walked one at a time with the original 
+    face walk, findSymmetricalVertices, instead.
+*/
+void PolySymmetryData::findSymmetricalShells(vector<ComponentSelection> &selections, bool faceWalk)
+{
+    if (faceWalk)
+    {
+        for (ComponentSelection &selection : selections)
+        {
+            this->findSymmetricalVertices(selection);
+        }
+
+        return;
+    }
+
+    for (ComponentSelection &selection : selections)
+    {
+        if (selection.leftVertexIndex != -1) 
+        {
+            leftSideVertexIndices.push_back(selection.leftVertexIndex);
+        }
+    }
+
+    // A selection may seed a pair of mirrored shells, like the eyes, so the 
+    // shells it touches are grouped and walked on the same thread.
+    vector<int> shellGroups(meshData.numberOfShells);
+
+    for (int i = 0; i < meshData.numberOfShells; i++)
+    {
+        shellGroups[i] = i;
+    }
+
+    for (ComponentSelection &selection : selections)
+    {
+        int group0 = findShellGroup(shellGroups, meshData.vertexShells[selection.vertexIndices.first]);
+        int group1 = findShellGroup(shellGroups, meshData.vertexShells[selection.vertexIndices.second]);
+
+        shellGroups[max(group0, group1)] = min(group0, group1);
+    }
+
+    vector<int> groupIndices(meshData.numberOfShells, -1);
+    vector<vector<int>> groupSelections;
+
+    for (int i = 0; i < (int) selections.size(); i++)
+    {
+        int group = findShellGroup(shellGroups, meshData.vertexShells[selections[i].vertexIndices.first]);
+
+        if (groupIndices[group] == -1)
+        {
+            groupIndices[group] = (int) groupSelections.size();
+            groupSelections.push_back(vector<int>());
+        }
+
+        groupSelections[groupIndices[group]].push_back(i);
+    }
+
+    int numberOfGroups = (int) groupSelections.size();
+    int numberOfThreads = ThreadPool::numberOfThreads();
+
+    if (numberOfGroups < 2 || numberOfThreads < 2)
+    {
+        for (ComponentSelection &selection : selections)
+        {
+            this->walkHalfEdges(selection, examined, symmetricalHalfEdges);
+        }
+
+        return;
+    }
+
+    // Start the biggest groups first, so one large shell does not finish last.
+    vector<int> groupSizes(numberOfGroups, 0);
+
+    for (int v = 0; v < meshData.numberOfVertices; v++)
+    {
+        int group = groupIndices[findShellGroup(shellGroups, meshData.vertexShells[v])];
+
+        if (group != -1) { groupSizes[group]++; }
+    }
+
+    vector<int> groupOrder(numberOfGroups);
+
+    for (int i = 0; i < numberOfGroups; i++)
+    {
+        groupOrder[i] = i;
+    }
+
+    sort(groupOrder.begin(), groupOrder.end(), [&](int a, int b) { return groupSizes[a] > groupSizes[b]; });
+
+    vector<ExaminedComponents> threadExamined(numberOfThreads, examined);
+    vector<vector<pair<int, int>>> threadHalfEdges(numberOfThreads);
+
+    ThreadPool::parallelFor(
+        numberOfGroups, 
+        [&](int taskIndex, int threadIndex) 
+        {
+            for (int i : groupSelections[groupOrder[taskIndex]])
+            {
+                this->walkHalfEdges(selections[i], threadExamined[threadIndex], threadHalfEdges[threadIndex]);
+            }
+        }
+    );
+
+    for (ExaminedComponents &threadComponents : threadExamined)
+    {
+        examined.merge(threadComponents);
+    }
+}
+
+
+int PolySymmetryData::findShellGroup(vector<int> &shellGroups, int shellIndex)
+{
+    while (shellGroups[shellIndex] != shellIndex)
+    {
+        shellGroups[shellIndex] = shellGroups[shellGroups[shellIndex]];
+        shellIndex = shellGroups[shellIndex];
+    }
+
+    return shellIndex;
+}
+
+
+/*
+    Finds a seed for each shell from the rest positions of the vertices, so 
+    the symmetry can be computed without a selection. The mirror plane is 
+    the YZ plane, and +X is the left side. 
+
+    Seeds are built from faces on the left side of a shell, preferring faces 
+    on its center edge loop, by looking up the mirrored position of each 
+    vertex. A shell without a center edge loop, like an eye, is paired with 
+    the shell its vertices mirror onto. Each seed is tried by walking the 
+    shell, and the seed whose walk mirrors the most vertex positions is kept. 
+
+    Once timeLimit seconds have passed, each remaining shell tries only its 
+    first candidates, up to the first seed that could be built, so a slow 
+    shell does not leave the shells after it without a seed.
+    Returns the number of shells that have no seed.
+*/
+int PolySymmetryData::findSymmetrySeeds(const MPointArray &points, double tolerance, double timeLimit, vector<ComponentSelection> &selections, vector<int> &seedLeftVertexIndices)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimit));
+
+    this->reset();
+
+    SpatialGrid grid;
+    grid.build(points, tolerance);
+
+    vector<int> edgeShells(meshData.numberOfEdges);
+    vector<int> faceShells(meshData.numberOfFaces);
+
+    for (int e = 0; e < meshData.numberOfEdges; e++)
+    {
+        edgeShells[e] = meshData.vertexShells[meshData.edgeVertices[e][0]];
+    }
+
+    for (int f = 0; f < meshData.numberOfFaces; f++)
+    {
+        faceShells[f] = meshData.vertexShells[meshData.faceCorners[f][0]];
+    }
+
+    AdjacencyList shellVertices;
+    AdjacencyList shellEdges;
+    AdjacencyList shellFaces;
+
+    groupByShell(meshData.vertexShells, meshData.numberOfShells, shellVertices);
+    groupByShell(edgeShells, meshData.numberOfShells, shellEdges);
+    groupByShell(faceShells, meshData.numberOfShells, shellFaces);
+
+    vector<bool> solvedShells(meshData.numberOfShells, false);
+    vector<int> candidateFaces;
+    vector<int> seedShells;
+
+    for (int s = 0; s < meshData.numberOfShells; s++)
+    {
+        if (solvedShells[s]) { continue; }
+
+        this->getSeedCandidates(s, shellFaces, points, tolerance, candidateFaces);
+
+        ComponentSelection bestSeed;
+        int bestScore = 0;
+        int bestShell = -1;
+        int numberOfScoredSeeds = 0;
+
+        for (int &f : candidateFaces)
+        {
+            if (numberOfScoredSeeds > 0 && chrono::steady_clock::now() > deadline) { break; }
+
+            ComponentSelection seed;
+
+            if (!this->getSeedFromFace(f, points, grid, tolerance, seed)) { continue; }
+
+            int mirrorShell = meshData.vertexShells[seed.vertexIndices.second];
+
+            if (solvedShells[mirrorShell]) { continue; }
+
+            seedShells.clear();
+            seedShells.push_back(s);
+
+            if (mirrorShell != s) { seedShells.push_back(mirrorShell); }
+
+            int score = this->scoreSeed(seed, seedShells, shellVertices, points, tolerance);
+            this->clearShells(seedShells, shellVertices, shellEdges, shellFaces);
+
+            numberOfScoredSeeds++;
+
+            if (score > bestScore)
+            {
+                bestSeed = seed;
+                bestScore = score;
+                bestShell = mirrorShell;
+            }
+
+            int numberOfVertices = 0;
+
+            for (int &i : seedShells)
+            {
+                numberOfVertices += shellVertices.rowSize(i);
+            }
+
+            if (score == numberOfVertices) { break; }
+        }
+
+        if (bestShell == -1) { continue; }
+
+        solvedShells[s] = true;
+        solvedShells[bestShell] = true;
+
+        selections.push_back(bestSeed);
+        seedLeftVertexIndices.push_back(bestSeed.leftVertexIndex);
+    }
+
+    this->reset();
+
+    return (int) count(solvedShells.begin(), solvedShells.end(), false);
+}
+
+
+/*
+    Lists the components in each shell, given the shell of each component.
+*/
+static void groupByShell(const vector<int> &componentShells, int numberOfShells, AdjacencyList &shellComponents)
+{
+    AdjacencyList componentShellList;
+
+    vector<int> rowSizes(componentShells.size(), 1);
+    vector<int> rowIndices(componentShells);
+
+    componentShellList.setRows(rowSizes, rowIndices);
+
+    shellComponents.transpose(componentShellList, numberOfShells);
+}
+
+
+/*
+    Lists the faces on the left side of a shell to build seeds from. Faces on 
+    the center edge loop come first, since their mirrors are close by and 
+    are on the same shell. The rest are spread evenly across the shell.
+*/
+void PolySymmetryData::getSeedCandidates(int shellIndex, const AdjacencyList &shellFaces, const MPointArray &points, double tolerance, vector<int> &candidateFaces)
+{
+    vector<int> centerFaces;
+    vector<int> leftFaces;
+
+    for (const int &f : shellFaces[shellIndex])
+    {
+        IndexRange corners = meshData.faceCorners[f];
+
+        double centerX = 0.0;
+        bool isOnCenter = false;
+
+        for (const int &v : corners)
+        {
+            centerX += points[v].x;
+            isOnCenter = isOnCenter || fabs(points[v].x) <= tolerance;
+        }
+
+        if (centerX / (double) corners.size() <= tolerance) { continue; }
+
+        if (isOnCenter)
+        {
+            centerFaces.push_back(f);
+        } else {
+            leftFaces.push_back(f);
+        }
+    }
+
+    candidateFaces.clear();
+
+    for (vector<int>* faces : {&centerFaces, &leftFaces})
+    {
+        int numberOfFaces = (int) faces->size();
+        int numberOfCandidates = min(numberOfFaces, AUTOMATIC_SEED_CANDIDATES - (int) candidateFaces.size());
+
+        for (int i = 0; i < numberOfCandidates; i++)
+        {
+            candidateFaces.push_back((*faces)[(int) ((int64_t) i * numberOfFaces / numberOfCandidates)]);
+        }
+    }
+}
+
+
+/*
+    Builds a seed from a face on the left side and the face that its vertices 
+    mirror onto. Returns false if any of the mirrored components is missing.
+*/
+bool PolySymmetryData::getSeedFromFace(int faceIndex, const MPointArray &points, const SpatialGrid &grid, double tolerance, ComponentSelection &seed)
+{
+    IndexRange corners = meshData.faceCorners[faceIndex];
+    int firstCorner = meshData.faceCorners.offsets[faceIndex];
+    int faceSize = corners.size();
+
+    if (faceSize < 3) { return false; }
+
+    vector<int> mirrorVertices(faceSize);
+
+    for (int i = 0; i < faceSize; i++)
+    {
+        const MPoint &point = points[corners[i]];
+
+        mirrorVertices[i] = grid.findClosestPoint(MPoint(-point.x, point.y, point.z), tolerance);
+
+        if (mirrorVertices[i] == -1) { return false; }
+    }
+
+    // An edge that crosses the center is its own mirror, so it cannot seed a walk.
+    for (int i = 0; i < faceSize; i++)
+    {
+        int next = (i + 1) % faceSize;
+        int edge0 = meshData.faceCornerEdges[firstCorner + i];
+
+        if (edge0 == -1 || mirrorVertices[i] == corners[next]) { continue; }
+
+        int edge1 = singleIntersection(
+            meshData.vertexEdges[mirrorVertices[i]], 
+            meshData.vertexEdges[mirrorVertices[next]]
+        );
+
+        if (edge1 == -1 || edge1 == edge0) { continue; }
+
+        int face1 = -1;
+        int other = mirrorVertices[(i + 2) % faceSize];
+
+        for (const int &f : meshData.edgeFaces[edge1])
+        {
+            if (meshData.faceCorners.rowSize(f) == faceSize && contains(meshData.faceVertices[f], other))
+            {
+                face1 = f;
+            }
+        }
+
+        if (face1 == -1 || face1 == faceIndex) { return false; }
+
+        seed.edgeIndices = pair<int, int>(edge0, edge1);
+        seed.faceIndices = pair<int, int>(faceIndex, face1);
+        seed.vertexIndices = pair<int, int>(corners[i], mirrorVertices[i]);
+
+        seed.leftVertexIndex = corners[0];
+
+        for (const int &v : corners)
+        {
+            if (points[v].x > points[seed.leftVertexIndex].x) { seed.leftVertexIndex = v; }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+    Walks the seed and counts the vertices on its shells whose mirror is 
+    where the walk put it. The walk is left in the symmetry tables.
+*/
+int PolySymmetryData::scoreSeed(ComponentSelection &seed, const vector<int> &seedShells, const AdjacencyList &shellVertices, const MPointArray &points, double tolerance)
+{
+    this->walkHalfEdges(seed, examined, symmetricalHalfEdges);
+
+    int score = 0;
+
+    for (const int &s : seedShells)
+    {
+        for (const int &v : shellVertices[s])
+        {
+            int mirrorIndex = vertexSymmetryIndices[v];
+
+            if (mirrorIndex == -1) { continue; }
+
+            const MPoint &point = points[v];
+            const MPoint &mirrorPoint = points[mirrorIndex];
+
+            double dx = point.x + mirrorPoint.x;
+            double dy = point.y - mirrorPoint.y;
+            double dz = point.z - mirrorPoint.z;
+
+            if (dx * dx + dy * dy + dz * dz <= tolerance * tolerance) { score++; }
+        }
+    }
+
+    return score;
+}
+
+
+/*
+    Undoes a walk on the given shells, so another seed can be tried on them.
+*/
+void PolySymmetryData::clearShells(const vector<int> &seedShells, const AdjacencyList &shellVertices, const AdjacencyList &shellEdges, const AdjacencyList &shellFaces)
+{
+    for (const int &s : seedShells)
+    {
+        for (const int &v : shellVertices[s])
+        {
+            vertexSymmetryIndices[v] = -1;
+            examined.vertices.unset(v);
+        }
+
+        for (const int &e : shellEdges[s])
+        {
+            edgeSymmetryIndices[e] = -1;
+            examined.edges.unset(e);
+        }
+
+        for (const int &f : shellFaces[s])
+        {
+            faceSymmetryIndices[f] = -1;
+            examined.faces.unset(f);
+        }
+    }
+}
+
+
+/*
+    Computes the symmetry from the rest positions of the vertices alone, for 
+    meshes whose topology is not symmetrical, like scans. The mirror plane 
+    is the YZ plane, and +X is the left side. 
+
+    Each vertex is matched to the vertex closest to its mirrored position, 
+    and the match is kept only if it is mutual. Edges and faces are mirrored 
+    through the vertex matches. Every pass writes only the entries of the 
+    components in its own chunk, so the passes are split across the thread 
+    pool. Components without a match are left at -1.
+*/
+void PolySymmetryData::findSymmetryByPosition(const MPointArray &points, double tolerance)
+{
+    this->reset();
+
+    SpatialGrid grid;
+    grid.build(points, tolerance);
+
+    vector<int> closestVertices(meshData.numberOfVertices, -1);
+
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfVertices),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            int last = min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfVertices);
+
+            for (int i = first; i < last; i++)
+            {
+                const MPoint &point = points[i];
+                closestVertices[i] = grid.findClosestPoint(MPoint(-point.x, point.y, point.z), tolerance);
+            }
+        }
+    );
+
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfVertices),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            this->findMirroredVertices(first, min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfVertices), points, tolerance, closestVertices);
+        }
+    );
+
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfEdges),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            this->findMirroredEdges(first, min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfEdges));
+        }
+    );
+
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfFaces),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            this->findMirroredFaces(first, min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfFaces));
+        }
+    );
+}
+
+
+/*
+    Keeps the mutual matches between vertices and their closest mirrored 
+    vertex, and sets the side of each vertex from its position.
+*/
+void PolySymmetryData::findMirroredVertices(int first, int last, const MPointArray &points, double tolerance, const vector<int> &closestVertices)
+{
+    int LEFT = 1;
+    int RIGHT = -1;
+    int CENTER = 0;
+
+    for (int i = first; i < last; i++)
+    {
+        int mirrorIndex = closestVertices[i];
+
+        if (mirrorIndex != -1 && closestVertices[mirrorIndex] == i)
+        {
+            vertexSymmetryIndices[i] = mirrorIndex;
+            examined.vertices.set(i);
+        }
+
+        double x = points[i].x;
+
+        vertexSides[i] = x > tolerance ? LEFT : (x < -tolerance ? RIGHT : CENTER);
+    }
+}
+
+
+void PolySymmetryData::findMirroredEdges(int first, int last)
+{
+    for (int i = first; i < last; i++)
+    {
+        int mirrorIndex = this->getMirroredEdge(i);
+
+        if (mirrorIndex != -1)
+        {
+            edgeSymmetryIndices[i] = mirrorIndex;
+            examined.edges.set(i);
+        }
+    }
+}
+
+
+void PolySymmetryData::findMirroredFaces(int first, int last)
+{
+    for (int i = first; i < last; i++)
+    {
+        int mirrorIndex = this->getMirroredFace(i);
+
+        if (mirrorIndex != -1)
+        {
+            faceSymmetryIndices[i] = mirrorIndex;
+            examined.faces.set(i);
+        }
+    }
+}
+
+
+/*
+    Returns the edge between the mirrors of the vertices on an edge, 
+    or -1 if there is none.
+*/
+int PolySymmetryData::getMirroredEdge(int edgeIndex) const
+{
+    int mirrorVertex0 = vertexSymmetryIndices[meshData.edgeVertices[edgeIndex][0]];
+    int mirrorVertex1 = vertexSymmetryIndices[meshData.edgeVertices[edgeIndex][1]];
+
+    if (mirrorVertex0 == -1 || mirrorVertex1 == -1) { return -1; }
+
+    return singleIntersection(meshData.vertexEdges[mirrorVertex0], meshData.vertexEdges[mirrorVertex1]);
+}
+
+
+/*
+    Returns the face of the same size around the mirror of every vertex on 
+    a face, found on the mirror of one of its edges, or -1 if there is none.
+*/
+int PolySymmetryData::getMirroredFace(int faceIndex) const
+{
+    IndexRange faceVertices = meshData.faceVertices[faceIndex];
+
+    int mirrorEdge = -1;
+
+    for (int c = meshData.faceCorners.offsets[faceIndex]; c < meshData.faceCorners.offsets[faceIndex + 1] && mirrorEdge == -1; c++)
+    {
+        int e = meshData.faceCornerEdges[c];
 
-    vertexSymmetryIndices = vector<int>();
-    edgeSymmetryIndices = vector<int>();
-    faceSymmetryIndices = vector<int>();
+        if (e != -1) { mirrorEdge = edgeSymmetryIndices[e]; }
+    }
 
-    vertexSides = vector<int>();
-    edgeSides = vector<int>();
-    faceSides = vector<int>();
+    if (mirrorEdge == -1) { return -1; }
 
-    leftSideVertexIndices = vector<int>();
-}
+    for (const int &f : meshData.edgeFaces[mirrorEdge])
+    {
+        if (meshData.faceVertices.rowSize(f) != faceVertices.size()) { continue; }
 
+        bool isMirror = true;
 
-PolySymmetryData::~PolySymmetryData() 
-{
-    this->clear();
-}
+        for (const int &v : faceVertices)
+        {
+            int mirrorIndex = vertexSymmetryIndices[v];
+
+            if (mirrorIndex == -1 || !binary_search(meshData.faceVertices[f].begin(), meshData.faceVertices[f].end(), mirrorIndex))
+            {
+                isMirror = false;
+                break;
+            }
+        }
 
+        if (isMirror) { return f; }
+    }
 
-void PolySymmetryData::initialize(MDagPath &mesh) 
-{
-    meshData.unpackMesh(mesh);
-    this->reset();
+    return -1;
 }
 
-
-void PolySymmetryData::clear()
+/*
+    Fills the gaps a topology walk leaves, like the regions past a pole or a 
+    non-manifold edge, by matching the unresolved vertices by their mirrored 
+    position. Only the unresolved vertices are put in the spatial grid. A 
+    match is kept if it is mutual, and if the solved neighbors of the vertex 
+    mirror onto neighbors of its match. Unresolved edges and faces are then 
+    mirrored through the vertex matches.
+
+    Apart from scanning the examined flags a word at a time, the cost is 
+    proportional to the number of unresolved components.
+    Returns the number of vertices that were matched.
+*/
+int PolySymmetryData::fillSymmetryGaps(const MPointArray &points, double tolerance)
 {
-    meshData.clear();
-    this->reset();
-}
+    vector<int> unresolvedVertices;
 
+    for (int v = examined.vertices.findNextUnset(); v != -1; v = examined.vertices.findNextUnset(v + 1))
+    {
+        unresolvedVertices.push_back(v);
+    }
 
-void PolySymmetryData::reset()
-{
-    examinedEdges.clear();
-    examinedFaces.clear();
-    examinedVertices.clear();
+    if (unresolvedVertices.empty()) { return 0; }
 
-    edgeSymmetryIndices.clear();
-    faceSymmetryIndices.clear();
-    vertexSymmetryIndices.clear();
+    SpatialGrid grid;
+    grid.build(points, unresolvedVertices, tolerance);
 
-    edgeSides.clear();
-    faceSides.clear();
-    vertexSides.clear();
+    int numberOfUnresolvedVertices = (int) unresolvedVertices.size();
+    vector<int> matches(numberOfUnresolvedVertices, -1);
 
-    leftSideVertexIndices.clear();
+    for (int i = 0; i < numberOfUnresolvedVertices; i++)
+    {
+        int vertexIndex = unresolvedVertices[i];
 
-    examinedEdges.resize(meshData.numberOfEdges, false);
-    examinedFaces.resize(meshData.numberOfFaces, false);
-    examinedVertices.resize(meshData.numberOfVertices, false);
+        const MPoint &point = points[vertexIndex];
+        int mirrorIndex = grid.findClosestPoint(MPoint(-point.x, point.y, point.z), tolerance);
 
-    edgeSymmetryIndices.resize(meshData.numberOfEdges, -1);
-    faceSymmetryIndices.resize(meshData.numberOfFaces, -1);
-    vertexSymmetryIndices.resize(meshData.numberOfVertices, -1);
+        if (mirrorIndex == -1) { continue; }
 
-    edgeSides.resize(meshData.numberOfEdges, -1);
-    faceSides.resize(meshData.numberOfFaces, -1);
-    vertexSides.resize(meshData.numberOfVertices, -1);
-}
+        const MPoint &mirrorPoint = points[mirrorIndex];
 
+        if (grid.findClosestPoint(MPoint(-mirrorPoint.x, mirrorPoint.y, mirrorPoint.z), tolerance) != vertexIndex) { continue; }
 
-void PolySymmetryData::findSymmetricalVertices(ComponentSelection &selection)
-{
-    queue<pair<int, int>> symmetricalEdgesQueue = queue<pair<int, int>>();
-    symmetricalEdgesQueue.push(selection.edgeIndices);
+        if (this->isConsistentMirror(vertexIndex, mirrorIndex))
+        {
+            matches[i] = mirrorIndex;
+        }
+    }
 
-    if (selection.leftVertexIndex != -1) 
+    // Matches are applied after they are all checked, so every check is 
+    // made against the result of the walk alone.
+    int numberOfMatches = 0;
+
+    for (int i = 0; i < numberOfUnresolvedVertices; i++)
     {
-        leftSideVertexIndices.push_back(selection.leftVertexIndex);
-    }
+        if (matches[i] == -1) { continue; }
 
-    this->findFirstSymmetricalVertices(selection);
+        vertexSymmetryIndices[unresolvedVertices[i]] = matches[i];
+        examined.vertices.set(unresolvedVertices[i]);
 
-    while (!symmetricalEdgesQueue.empty())
+        numberOfMatches++;
+    }
+
+    for (int e = examined.edges.findNextUnset(); e != -1; e = examined.edges.findNextUnset(e + 1))
     {
-        pair<int, int> edgePair = symmetricalEdgesQueue.front();
-        symmetricalEdgesQueue.pop();
+        int mirrorIndex = this->getMirroredEdge(e);
 
-        markSymmetricalEdges(edgePair.first, edgePair.second);
+        if (mirrorIndex == -1) { continue; }
 
-        pair<int, int> facesPair = getUnexaminedFaces(edgePair);
+        if (!examined.edges[mirrorIndex] || edgeSymmetryIndices[mirrorIndex] == e)
+        {
+            edgeSymmetryIndices[e] = mirrorIndex;
+            examined.edges.set(e);
+        }
+    }
 
-        if (facesPair.first == -1 || facesPair.second == -1)
+    for (int f = examined.faces.findNextUnset(); f != -1; f = examined.faces.findNextUnset(f + 1))
+    {
+        int mirrorIndex = this->getMirroredFace(f);
+
+        if (mirrorIndex == -1) { continue; }
+
+        if (!examined.faces[mirrorIndex] || faceSymmetryIndices[mirrorIndex] == f)
         {
-            continue;
+            faceSymmetryIndices[f] = mirrorIndex;
+            examined.faces.set(f);
         }
+    }
 
-        markSymmetricalFaces(facesPair.first, facesPair.second);
+    return numberOfMatches;
+}
 
-        this->findSymmetricalVerticesOnFace(facesPair);
-        this->findSymmetricalEdgesOnFace(symmetricalEdgesQueue, facesPair.first);
+
+/*
+    Returns true if every solved neighbor of a vertex mirrors onto a 
+    neighbor of mirrorIndex.
+*/
+bool PolySymmetryData::isConsistentMirror(int vertexIndex, int mirrorIndex) const
+{
+    IndexRange mirrorNeighbors = meshData.vertexVertices[mirrorIndex];
+
+    for (const int &v : meshData.vertexVertices[vertexIndex])
+    {
+        int mirrorNeighbor = vertexSymmetryIndices[v];
+
+        if (mirrorNeighbor == -1) { continue; }
+
+        if (!binary_search(mirrorNeighbors.begin(), mirrorNeighbors.end(), mirrorNeighbor)) 
+        { 
+            return false; 
+        }
     }
+
+    return true;
 }
 
 
-void PolySymmetryData::findFirstSymmetricalVertices(ComponentSelection &selection)
+
+/*
+    Walks the shell seeded by the selection. Only the components reached 
+    from the selection are written to, so walks on other shells can run at 
+    the same time with their own examined flags and half-edge queue.
+*/
+void PolySymmetryData::walkHalfEdges(ComponentSelection &selection, ExaminedComponents &examinedComponents, vector<pair<int, int>> &halfEdgeQueue)
 {
-    markSymmetricalVertices(selection.vertexIndices.first, selection.vertexIndices.second);
-    markSymmetricalFaces(selection.faceIndices.first, selection.faceIndices.second);
-    
-    int vertex0 = meshData.edgeData[selection.edgeIndices.first].connectedVertices[0];
-    int vertex1 = meshData.edgeData[selection.edgeIndices.first].connectedVertices[1];
+    int h0 = halfEdgeMesh.findHalfEdge(selection.faceIndices.first, selection.edgeIndices.first);
+    int h1 = halfEdgeMesh.findHalfEdge(selection.faceIndices.second, selection.edgeIndices.second);
+
+    if (h0 == -1 || h1 == -1)
+    {
+        return;
+    }
 
-    int nextVertex0 = examinedVertices[vertex0] ? vertex1 : vertex0;
+    markSymmetricalVertices(selection.vertexIndices.first, selection.vertexIndices.second, examinedComponents);
+    markSymmetricalFaces(selection.faceIndices.first, selection.faceIndices.second, examinedComponents);
+    markSymmetricalEdges(selection.edgeIndices.first, selection.edgeIndices.second, examinedComponents);
 
-    vertex0 = meshData.edgeData[selection.edgeIndices.second].connectedVertices[0];
-    vertex1 = meshData.edgeData[selection.edgeIndices.second].connectedVertices[1];
+    int nextVertex0 = examinedComponents.vertices[halfEdgeMesh.origin[h0]] ? halfEdgeMesh.destination(h0) : halfEdgeMesh.origin[h0];
+    int nextVertex1 = examinedComponents.vertices[halfEdgeMesh.origin[h1]] ? halfEdgeMesh.destination(h1) : halfEdgeMesh.origin[h1];
 
-    int nextVertex1 = examinedVertices[vertex0] ? vertex1 : vertex0;
+    markSymmetricalVertices(nextVertex0, nextVertex1, examinedComponents);
 
-    markSymmetricalVertices(nextVertex0, nextVertex1);
+    // The queue is kept between walks, so it only grows to fit the largest shell.
+    halfEdgeQueue.clear();
+    halfEdgeQueue.push_back(pair<int, int>(h0, h1));
 
-    this->findSymmetricalVerticesOnFace(selection.faceIndices);
+    this->findSymmetricalHalfEdgesOnFace(h0, h1, examinedComponents, halfEdgeQueue);
+
+    for (size_t i = 0; i < halfEdgeQueue.size(); i++)
+    {
+        int twin0 = this->getUnexaminedTwin(halfEdgeQueue[i].first, examinedComponents);
+        int twin1 = this->getUnexaminedTwin(halfEdgeQueue[i].second, examinedComponents);
+
+        if (twin0 == -1 || twin1 == -1)
+        {
+            continue;
+        }
+
+        int face0 = halfEdgeMesh.face[twin0];
+        int face1 = halfEdgeMesh.face[twin1];
+
+        markSymmetricalFaces(face0, face1, examinedComponents);
+
+        this->findSymmetricalHalfEdgesOnFace(twin0, twin1, examinedComponents, halfEdgeQueue);
+    }
 }
 
 
 pair<int, int> PolySymmetryData::getUnexaminedFaces(pair<int, int> &edgePair)
 {
-    vector<int> sharedFaces = intersection(
-        meshData.edgeData[edgePair.first].connectedFaces,
-        meshData.edgeData[edgePair.second].connectedFaces
+    int numberOfSharedFaces = intersection(
+        meshData.edgeFaces[edgePair.first],
+        meshData.edgeFaces[edgePair.second],
+        sharedComponents
     );
 
     int face0 = -1;
     int face1 = -1;
 
-    if (sharedFaces.size() > 0)
+    if (numberOfSharedFaces > 0)
     {
-        for (int &faceIndex : sharedFaces)
+        for (int &faceIndex : sharedComponents)
         {
-            if (this->examinedFaces[faceIndex])
+            if (examined.faces[faceIndex])
             {
                 continue;
             }
@@ -220,9 +1034,9 @@ int PolySymmetryData::getUnexaminedFace(int &edgeIndex)
 {
     int result = -1;
 
-    for (int &faceIndex : meshData.edgeData[edgeIndex].connectedFaces)
+    for (const int &faceIndex : meshData.edgeFaces[edgeIndex])
     {
-        if (!examinedFaces[faceIndex])
+        if (!examined.faces[faceIndex])
         {
             result = faceIndex;
             break;
@@ -235,20 +1049,19 @@ int PolySymmetryData::getUnexaminedFace(int &edgeIndex)
 
 void PolySymmetryData::findSymmetricalVerticesOnFace(pair<int, int> &facePair)
 {
-    queue<int> faceVerticesQueue = queue<int>();
+    faceVerticesQueue.clear();
     
-    for (int &v : meshData.faceData[facePair.first].connectedVertices)
+    for (const int &v : meshData.faceVertices[facePair.first])
     {
-        if (examinedVertices[v])
+        if (examined.vertices[v])
         {
-            faceVerticesQueue.push(v);
+            faceVerticesQueue.push_back(v);
         }
     }
 
-    while (!faceVerticesQueue.empty())
+    for (size_t i = 0; i < faceVerticesQueue.size(); i++)
     {
-        int vertex0 = faceVerticesQueue.front();
-        faceVerticesQueue.pop();
+        int vertex0 = faceVerticesQueue[i];
 
         int vertex1 = vertexSymmetryIndices[vertex0];
 
@@ -262,7 +1075,7 @@ void PolySymmetryData::findSymmetricalVerticesOnFace(pair<int, int> &facePair)
 
         markSymmetricalVertices(nextVertex0, nextVertex1);
 
-        faceVerticesQueue.push(nextVertex0);
+        faceVerticesQueue.push_back(nextVertex0);
     }
 }
 
@@ -274,28 +1087,26 @@ void PolySymmetryData::findSymmetricalEdgesOnFace(queue<pair<int, int>> &symmetr
 
     int edgeIndex;
 
-    for (int &e : meshData.faceData[faceIndex].connectedEdges)
+    for (int e : meshData.faceEdges[faceIndex])
     {
-        if (examinedEdges[e]) { continue; }
+        if (examined.edges[e]) { continue; }
 
-        vertex0 = vertexSymmetryIndices[meshData.edgeData[e].connectedVertices[0]];
-        vertex1 = vertexSymmetryIndices[meshData.edgeData[e].connectedVertices[1]];
+        vertex0 = vertexSymmetryIndices[meshData.edgeVertices[e][0]];
+        vertex1 = vertexSymmetryIndices[meshData.edgeVertices[e][1]];
 
         if (vertex0 == -1 || vertex1 == -1)
         {
             continue;
         }
         
-        vector<int> sharedEdges = intersection(
-            meshData.vertexData[vertex0].connectedEdges, 
-            meshData.vertexData[vertex1].connectedEdges
+        edgeIndex = singleIntersection(
+            meshData.vertexEdges[vertex0], 
+            meshData.vertexEdges[vertex1]
         );
 
-        if (sharedEdges.size() != 1) { continue; }
-
-        edgeIndex = sharedEdges[0];
+        if (edgeIndex == -1) { continue; }
 
-        if (!examinedEdges[edgeIndex]) 
+        if (!examined.edges[edgeIndex]) 
         { 
             symmetricalEdgesQueue.push(pair<int, int>(e, edgeIndex));   
         }
@@ -306,143 +1117,331 @@ void PolySymmetryData::findSymmetricalEdgesOnFace(queue<pair<int, int>> &symmetr
 }
 
 
-int PolySymmetryData::getUnexaminedVertexSibling(int &vertexIndex, int &faceIndex)
+/*
+    Returns the twin of a half-edge whose face has not been examined, or -1. 
+    On an edge with more than two faces, this is the twin on the unexamined 
+    face with the lowest index, which is the face getUnexaminedFace picks, 
+    so the walk carries on across non-manifold edges as the face walk does.
+*/
+int PolySymmetryData::getUnexaminedTwin(int halfEdge, ExaminedComponents &examinedComponents)
 {
     int result = -1;
 
-    for (int &v : meshData.vertexData[vertexIndex].faceVertexSiblings[faceIndex])
+    for (int h = halfEdgeMesh.twin[halfEdge]; h != -1 && h != halfEdge; h = halfEdgeMesh.twin[h])
+    {
+        int faceIndex = halfEdgeMesh.face[h];
+
+        if (examinedComponents.faces[faceIndex]) { continue; }
+
+        if (result == -1 || faceIndex < halfEdgeMesh.face[result])
+        {
+            result = h;
+        }
+    }
+
+    return result;
+}
+
+
+/*
+    Walks the faces of a pair of symmetrical half-edges, whose vertices are 
+    already known to be symmetrical, marking the vertices and edges on the way.
+    Pairs of newly found edges are added to halfEdgeQueue.
+*/
+void PolySymmetryData::findSymmetricalHalfEdgesOnFace(int h0, int h1, ExaminedComponents &examinedComponents, vector<pair<int, int>> &halfEdgeQueue)
+{
+    int faceSize = halfEdgeMesh.faceSize(halfEdgeMesh.face[h0]);
+
+    if (faceSize != halfEdgeMesh.faceSize(halfEdgeMesh.face[h1]))
+    {
+        return;
+    }
+
+    // Mirroring usually reverses the winding order, in which case the walk 
+    // on the second face goes backwards.
+    bool reversed = vertexSymmetryIndices[halfEdgeMesh.origin[h0]] != halfEdgeMesh.origin[h1];
+
+    int halfEdge0 = h0;
+    int halfEdge1 = h1;
+
+    for (int i = 1; i < faceSize; i++)
     {
-        if (examinedVertices[v]) 
+        halfEdge0 = halfEdgeMesh.next[halfEdge0];
+        halfEdge1 = reversed ? halfEdgeMesh.prev[halfEdge1] : halfEdgeMesh.next[halfEdge1];
+
+        int vertex0 = halfEdgeMesh.destination(halfEdge0);
+        int vertex1 = reversed ? halfEdgeMesh.origin[halfEdge1] : halfEdgeMesh.destination(halfEdge1);
+
+        if (!examinedComponents.vertices[vertex0] && !examinedComponents.vertices[vertex1])
+        {
+            markSymmetricalVertices(vertex0, vertex1, examinedComponents);
+        }
+
+        int edge0 = halfEdgeMesh.edge[halfEdge0];
+        int edge1 = halfEdgeMesh.edge[halfEdge1];
+
+        if (edge0 == -1 || edge1 == -1 || examinedComponents.edges[edge0])
         {
             continue;
         }
 
-        result = v;
-        break;
+        if (!examinedComponents.edges[edge1])
+        {
+            halfEdgeQueue.push_back(pair<int, int>(halfEdge0, halfEdge1));
+        }
+
+        markSymmetricalEdges(edge0, edge1, examinedComponents);
     }
+}
 
-    return result;
+
+int PolySymmetryData::getUnexaminedVertexSibling(int &vertexIndex, int &faceIndex)
+{
+    int previousVertex;
+    int nextVertex;
+
+    if (!meshData.getFaceVertexSiblings(vertexIndex, faceIndex, previousVertex, nextVertex))
+    {
+        return -1;
+    }
+
+    // Siblings are tried lowest index first, as they were when they were stored sorted.
+    int firstVertex = min(previousVertex, nextVertex);
+    int secondVertex = max(previousVertex, nextVertex);
+
+    if (!examined.vertices[firstVertex]) { return firstVertex; }
+    if (!examined.vertices[secondVertex]) { return secondVertex; }
+
+    return -1;
 }
 
 
+/*
+    Floods the left side of the mesh out from the left side vertices, and the 
+    right side out from their mirrors, stopping at center vertices.
+*/
 void PolySymmetryData::findVertexSides(vector<int> &leftSideVertexIndices)
 {
     int LEFT = 1;
     int RIGHT = -1;
     int CENTER = 0;
 
-    vector<int> visitedVertices(meshData.numberOfVertices, false);
-    queue<int> nextVertexQueue = queue<int>();
+    BitArray visitedVertices;
+    visitedVertices.resize(meshData.numberOfVertices);
 
     vertexSides.clear();
-    vertexSides.resize(meshData.numberOfVertices, 0);
+    vertexSides.resize(meshData.numberOfVertices, CENTER);
+
+    vector<int> frontier;
 
     for (int &i : leftSideVertexIndices)
     {
-        nextVertexQueue.push(i);
+        frontier.push_back(i);
         vertexSides[i] = LEFT;
     }
 
-    int vertexIndex = -1;
+    this->floodVertexSides(frontier, LEFT, visitedVertices);
 
-    while (!nextVertexQueue.empty())
+    frontier.clear();
+
+    for (int &i : leftSideVertexIndices)
     {
-        vertexIndex = nextVertexQueue.front();
-        nextVertexQueue.pop();
+        int mirrorIndex = vertexSymmetryIndices[i];
 
-        if (visitedVertices[vertexIndex]) { continue; }
+        if (mirrorIndex == -1) { continue; }
 
-        visitedVertices[vertexIndex] = true;
+        frontier.push_back(mirrorIndex);
+        vertexSides[mirrorIndex] = RIGHT;
+    }
 
-        if (vertexSymmetryIndices[vertexIndex] == vertexIndex)
-        {
-            vertexSides[vertexIndex] = CENTER;
-        } else {
-            vertexSides[vertexIndex] = LEFT;
+    this->floodVertexSides(frontier, RIGHT, visitedVertices);
+}
 
-            for (int &i : meshData.vertexData[vertexIndex].connectedVertices)
-            {
-                if (!visitedVertices[i] && vertexSymmetryIndices[i] != vertexIndex) 
-                {
-                    nextVertexQueue.push(i);
-                }
-            }
-        }
-    }
 
-    for (int &i : leftSideVertexIndices)
+/*
+    Sets the side of the resolved vertices the flood did not reach, like the 
+    vertices of a shell that fillSymmetryGaps matched by position, from the 
+    sign of their x position, as findSymmetryByPosition does. The flood sets 
+    every vertex it reaches to a side unless it is its own mirror, so these 
+    are the center vertices that are not their own mirror.
+*/
+void PolySymmetryData::findUnreachedVertexSides(const MPointArray &points, double tolerance)
+{
+    int LEFT = 1;
+    int RIGHT = -1;
+    int CENTER = 0;
+
+    for (int i = 0; i < meshData.numberOfVertices; i++)
     {
-        nextVertexQueue.push(vertexSymmetryIndices[i]);
-        vertexSides[vertexSymmetryIndices[i]] = RIGHT;
+        int mirrorIndex = vertexSymmetryIndices[i];
+
+        if (vertexSides[i] != CENTER || mirrorIndex == -1 || mirrorIndex == i) { continue; }
+
+        double x = points[i].x;
+
+        vertexSides[i] = x > tolerance ? LEFT : (x < -tolerance ? RIGHT : CENTER);
     }
+}
 
-    while (!nextVertexQueue.empty())
-    {
-        vertexIndex = nextVertexQueue.front();
-        nextVertexQueue.pop();
 
-        if (visitedVertices[vertexIndex]) { continue; }
+/*
+    Breadth first flood fill, one level at a time. Large levels are split 
+    across the thread pool. Each vertex is claimed by setting its visited 
+    flag atomically, so only one thread ever writes its side or queues it.
+*/
+void PolySymmetryData::floodVertexSides(vector<int> &frontier, int side, BitArray &visitedVertices)
+{
+    int LEFT = 1;
+    int CENTER = 0;
 
-        visitedVertices[vertexIndex] = true;
+    vector<int> level;
 
-        if (vertexSymmetryIndices[vertexIndex] == vertexIndex)
+    for (int &i : frontier)
+    {
+        if (!visitedVertices.testAndSet(i))
         {
-            vertexSides[vertexIndex] = CENTER;
-        } else {
-            vertexSides[vertexIndex] = RIGHT;
+            level.push_back(i);
+        }
+    }
+
+    vector<vector<int>> nextLevels(ThreadPool::numberOfThreads());
+
+    while (!level.empty())
+    {
+        int numberOfVertices = (int) level.size();
+
+        // Small levels run on this thread, where the visited flags can be set without atomics.
+        bool parallel = ThreadPool::numberOfThreads() > 1 && numberOfVertices > PARALLEL_CHUNK_SIZE;
 
-            for (int &i : meshData.vertexData[vertexIndex].connectedVertices)
+        ThreadPool::parallelFor(
+            numberOfChunks(numberOfVertices),
+            [&](int taskIndex, int threadIndex)
             {
-                if (!visitedVertices[i]) 
+                int last = min((taskIndex + 1) * PARALLEL_CHUNK_SIZE, numberOfVertices);
+
+                for (int j = taskIndex * PARALLEL_CHUNK_SIZE; j < last; j++)
                 {
-                    nextVertexQueue.push(i);
+                    int vertexIndex = level[j];
+
+                    if (vertexSymmetryIndices[vertexIndex] == vertexIndex)
+                    {
+                        vertexSides[vertexIndex] = CENTER;
+                        continue;
+                    } 
+
+                    vertexSides[vertexIndex] = side;
+
+                    for (const int &i : meshData.vertexVertices[vertexIndex])
+                    {
+                        if (side == LEFT && vertexSymmetryIndices[i] == vertexIndex) { continue; }
+
+                        bool visited = parallel ? visitedVertices.testAndSetAtomic(i) : visitedVertices.testAndSet(i);
+
+                        if (!visited) 
+                        {
+                            nextLevels[threadIndex].push_back(i);
+                        }
+                    }
                 }
             }
+        );
+
+        level.clear();
+
+        for (vector<int> &nextLevel : nextLevels)
+        {
+            level.insert(level.end(), nextLevel.begin(), nextLevel.end());
+            nextLevel.clear();
         }
     }
 }
 
 
 void PolySymmetryData::markSymmetricalVertices(int &i0, int &i1)
+{
+    this->markSymmetricalVertices(i0, i1, examined);
+}
+
+
+void PolySymmetryData::markSymmetricalVertices(int i0, int i1, ExaminedComponents &examinedComponents)
 {
     vertexSymmetryIndices[i0] = i1;
     vertexSymmetryIndices[i1] = i0;
 
-    examinedVertices[i0] = true;
-    examinedVertices[i1] = true;
+    examinedComponents.vertices.set(i0);
+    examinedComponents.vertices.set(i1);
 }
 
 
 void PolySymmetryData::markSymmetricalEdges(int &i0, int &i1)
+{
+    this->markSymmetricalEdges(i0, i1, examined);
+}
+
+
+void PolySymmetryData::markSymmetricalEdges(int i0, int i1, ExaminedComponents &examinedComponents)
 {
     edgeSymmetryIndices[i0] = i1;
     edgeSymmetryIndices[i1] = i0;
 
-    examinedEdges[i0] = true;
-    examinedEdges[i1] = true;
+    examinedComponents.edges.set(i0);
+    examinedComponents.edges.set(i1);
 }
 
 
 void PolySymmetryData::markSymmetricalFaces(int &i0, int &i1)
+{
+    this->markSymmetricalFaces(i0, i1, examined);
+}
+
+
+void PolySymmetryData::markSymmetricalFaces(int i0, int i1, ExaminedComponents &examinedComponents)
 {
     faceSymmetryIndices[i0] = i1;
     faceSymmetryIndices[i1] = i0;
 
-    examinedFaces[i0] = true;
-    examinedFaces[i1] = true;
+    examinedComponents.faces.set(i0);
+    examinedComponents.faces.set(i1);
 }
 
 
+/*
+    Sets the side of every edge and face from the sides of their vertices. 
+    Each component is independent, so both passes are split across the 
+    thread pool. Meshes smaller than one chunk are done on this thread.
+*/
 void PolySymmetryData::finalizeSymmetry() 
+{
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfEdges),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            this->finalizeEdgeSides(first, min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfEdges));
+        }
+    );
+
+    ThreadPool::parallelFor(
+        numberOfChunks(meshData.numberOfFaces),
+        [&](int taskIndex, int threadIndex)
+        {
+            int first = taskIndex * PARALLEL_CHUNK_SIZE;
+            this->finalizeFaceSides(first, min(first + PARALLEL_CHUNK_SIZE, meshData.numberOfFaces));
+        }
+    );
+}
+
+
+void PolySymmetryData::finalizeEdgeSides(int first, int last)
 {
     int LEFT = 1;
     int RIGHT = -1;
     int CENTER = 0;
 
-    for (int i = 0; i < meshData.numberOfEdges; i++)
+    for (int i = first; i < last; i++)
     {
-        int sv0 = vertexSides[meshData.edgeData[i].connectedVertices[0]];
-        int sv1 = vertexSides[meshData.edgeData[i].connectedVertices[1]];
+        int sv0 = vertexSides[meshData.edgeVertices[i][0]];
+        int sv1 = vertexSides[meshData.edgeVertices[i][1]];
 
         if (sv0 == CENTER && sv1 == CENTER)
         {
@@ -453,21 +1452,56 @@ void PolySymmetryData::finalizeSymmetry()
             edgeSides[i] = LEFT;
         }
     }
+}
 
-    vector<int> faceVertexSides;
 
-    for (int i = 0; i < meshData.numberOfFaces; i++)
+void PolySymmetryData::finalizeFaceSides(int first, int last)
+{
+    int LEFT = 1;
+    int RIGHT = -1;
+    int CENTER = 0;
+
+    for (int i = first; i < last; i++)
     {
-        faceVertexSides.resize(meshData.faceData[i].connectedVertices.size());
+        bool onTheLeft = false;
+        bool onTheRight = false;
 
-        for (int j = 0; j < meshData.faceData[i].connectedVertices.size(); j++)
+        for (int v : meshData.faceVertices[i])
         {
-            faceVertexSides[j] = vertexSides[meshData.faceData[i].connectedVertices[j]];
+            onTheLeft |= vertexSides[v] == LEFT;
+            onTheRight |= vertexSides[v] == RIGHT;
         }
 
-        bool onTheLeft = contains(faceVertexSides, LEFT);
-        bool onTheRight = contains(faceVertexSides, RIGHT);
-
         faceSides[i] = (onTheLeft ? LEFT : CENTER) + (onTheRight ? RIGHT : CENTER);
     }
+}
+
+
+int PolySymmetryData::numberOfChunks(int numberOfItems)
+{
+    return (numberOfItems + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+}
+
+
+void ExaminedComponents::clear()
+{
+    edges.clear();
+    faces.clear();
+    vertices.clear();
+}
+
+
+void ExaminedComponents::resize(const MeshData &meshData)
+{
+    edges.resize(meshData.numberOfEdges);
+    faces.resize(meshData.numberOfFaces);
+    vertices.resize(meshData.numberOfVertices);
+}
+
+
+void ExaminedComponents::merge(const ExaminedComponents &other)
+{
+    edges.merge(other.edges);
+    faces.merge(other.faces);
+    vertices.merge(other.vertices);
 }
\ No newline at end of file
@@ -6,17 +6,42 @@
 #ifndef POLY_SYMMETRY_H
 #define POLY_SYMMETRY_H
 
+#include "bitArray.h"
+#include "halfEdgeMesh.h"
 #include "meshData.h"
 #include "selection.h"
+#include "spatialGrid.h"
 
+#include <cstdint>
 #include <queue>
 #include <utility> 
 #include <vector>
 
 #include <maya/MDagPath.h>
+#include <maya/MPointArray.h>
 
 using namespace std;
 
+// Number of components given to each task when a pass is split across the thread pool.
+#define PARALLEL_CHUNK_SIZE 16384
+
+// Number of seeds tried on each shell when the seeds are found automatically.
+#define AUTOMATIC_SEED_CANDIDATES 8
+
+/*
+    Flags for the components a walk has already examined.
+*/
+struct ExaminedComponents
+{
+    BitArray                edges;
+    BitArray                faces;
+    BitArray                vertices;
+
+    void                    clear();
+    void                    resize(const MeshData &meshData);
+    void                    merge(const ExaminedComponents &other);
+};
+
 class PolySymmetryData
 {
 public:
@@ -26,10 +51,17 @@ public:
     virtual void            clear();
     virtual void            reset();
     virtual void            initialize(MDagPath &mesh);
+    virtual void            initialize(const MeshData &mesh);
 
     virtual void            findSymmetricalVertices(ComponentSelection &selection);
     virtual void            findFirstSymmetricalVertices(ComponentSelection &selection);
+    virtual void            findSymmetricalVerticesByHalfEdges(ComponentSelection &selection);
+    virtual void            findSymmetricalShells(vector<ComponentSelection> &selections, bool faceWalk=false);
+    virtual int             findSymmetrySeeds(const MPointArray &points, double tolerance, double timeLimit, vector<ComponentSelection> &selections, vector<int> &seedLeftVertexIndices);
+    virtual void            findSymmetryByPosition(const MPointArray &points, double tolerance);
+    virtual int             fillSymmetryGaps(const MPointArray &points, double tolerance);
     virtual void            findVertexSides(vector<int> &leftSideVertexIndices);
+    virtual void            findUnreachedVertexSides(const MPointArray &points, double tolerance);
     virtual void            finalizeSymmetry();
 
 private:
@@ -39,28 +71,61 @@ private:
 
     virtual void            findSymmetricalVerticesOnFace(pair<int, int> &facePair);
     virtual void            findSymmetricalEdgesOnFace(queue<pair<int, int>> &symmetricalEdgesQueue, int &faceIndex);
+    virtual void            walkHalfEdges(ComponentSelection &selection, ExaminedComponents &examinedComponents, vector<pair<int, int>> &halfEdgeQueue);
+    virtual void            findSymmetricalHalfEdgesOnFace(int h0, int h1, ExaminedComponents &examinedComponents, vector<pair<int, int>> &halfEdgeQueue);
+    virtual int             getUnexaminedTwin(int halfEdge, ExaminedComponents &examinedComponents);
 
     virtual void            markSymmetricalVertices(int &i0, int &i1);
     virtual void            markSymmetricalEdges(int &i0, int &i1);
     virtual void            markSymmetricalFaces(int &i0, int &i1);
 
+    virtual void            markSymmetricalVertices(int i0, int i1, ExaminedComponents &examinedComponents);
+    virtual void            markSymmetricalEdges(int i0, int i1, ExaminedComponents &examinedComponents);
+    virtual void            markSymmetricalFaces(int i0, int i1, ExaminedComponents &examinedComponents);
+
+    static int              findShellGroup(vector<int> &shellGroups, int shellIndex);
+
+    virtual void            getSeedCandidates(int shellIndex, const AdjacencyList &shellFaces, const MPointArray &points, double tolerance, vector<int> &candidateFaces);
+    virtual bool            getSeedFromFace(int faceIndex, const MPointArray &points, const SpatialGrid &grid, double tolerance, ComponentSelection &seed);
+    virtual int             scoreSeed(ComponentSelection &seed, const vector<int> &seedShells, const AdjacencyList &shellVertices, const MPointArray &points, double tolerance);
+    virtual void            clearShells(const vector<int> &seedShells, const AdjacencyList &shellVertices, const AdjacencyList &shellEdges, const AdjacencyList &shellFaces);
+
+    virtual void            findMirroredVertices(int first, int last, const MPointArray &points, double tolerance, const vector<int> &closestVertices);
+    virtual void            findMirroredEdges(int first, int last);
+    virtual void            findMirroredFaces(int first, int last);
+
+    int                     getMirroredEdge(int edgeIndex) const;
+    int                     getMirroredFace(int faceIndex) const;
+    bool                    isConsistentMirror(int vertexIndex, int mirrorIndex) const;
+
+    virtual void            floodVertexSides(vector<int> &frontier, int side, BitArray &visitedVertices);
+    virtual void            finalizeEdgeSides(int first, int last);
+    virtual void            finalizeFaceSides(int first, int last);
+
+    static int              numberOfChunks(int numberOfItems);
+
 public:
     vector<int>             vertexSymmetryIndices;
     vector<int>             edgeSymmetryIndices;
     vector<int>             faceSymmetryIndices;
 
-    vector<int>             vertexSides;
-    vector<int>             edgeSides;
-    vector<int>             faceSides;
+    // 1 for left, -1 for right, 0 for center.
+    vector<int8_t>          vertexSides;
+    vector<int8_t>          edgeSides;
+    vector<int8_t>          faceSides;
     
 private:    
     MeshData                meshData;
+    HalfEdgeMesh            halfEdgeMesh;
 
-    vector<bool>            examinedEdges;
-    vector<bool>            examinedFaces;
-    vector<bool>            examinedVertices;
+    ExaminedComponents      examined;
+    vector<pair<int, int>>  symmetricalHalfEdges;
 
     vector<int>             leftSideVertexIndices;
+
+    // Scratch buffers reused by the walk, so it does not allocate on every face.
+    vector<int>             sharedComponents;
+    vector<int>             faceVerticesQueue;
 };
 
 #endif
\ No newline at end of file
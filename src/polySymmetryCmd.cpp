@@ -3,12 +3,17 @@
     You may use, distribute, or modify this code under the terms of the MIT license.
 */
 
+#include "diskCache.h"
 #include "meshData.h"
 #include "polySymmetryCmd.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 #include "selection.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <sstream>
 #include <vector>
 
@@ -16,8 +21,12 @@
 #include <maya/MArgDatabase.h>
 #include <maya/MDGModifier.h>
 #include <maya/MFnDependencyNode.h>
+#include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
+#include <maya/MIntArray.h>
 #include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MPointArray.h>
 #include <maya/MSelectionList.h>
 #include <maya/MStatus.h>
 #include <maya/MString.h>
@@ -90,6 +99,25 @@ MSyntax PolySymmetryCommand::getSyntax()
         MSyntax::MArgType::kBoolean
     );
 
+    syntax.addFlag(VERBOSE_FLAG, VERBOSE_LONG_FLAG);
+    syntax.addFlag(AUTOMATIC_FLAG, AUTOMATIC_LONG_FLAG);
+    syntax.addFlag(GEOMETRIC_FLAG, GEOMETRIC_LONG_FLAG);
+    syntax.addFlag(FILL_GAPS_FLAG, FILL_GAPS_LONG_FLAG);
+    syntax.addFlag(SHARED_FLAG, SHARED_LONG_FLAG);
+    syntax.addFlag(FACE_WALK_FLAG, FACE_WALK_LONG_FLAG);
+
+    syntax.addFlag(
+        TOLERANCE_FLAG,
+        TOLERANCE_LONG_FLAG,
+        MSyntax::MArgType::kDouble
+    );
+
+    syntax.addFlag(
+        TIME_LIMIT_FLAG,
+        TIME_LIMIT_LONG_FLAG,
+        MSyntax::MArgType::kDouble
+    );
+
     syntax.makeFlagMultiUse(SYMMETRY_COMPONENTS_FLAG);
     syntax.makeFlagMultiUse(LEFT_SIDE_VERTEX_FLAG);
 
@@ -112,7 +140,35 @@ MStatus PolySymmetryCommand::doIt(const MArgList& argList)
         status = this->parseArguments(argsData);        
         RETURN_IF_ERROR(status);
 
+        if (this->linkToExistingNode)
+        {
+            if (this->constructionHistory)
+            {
+                status = this->linkMesh(this->linkModifier);
+                RETURN_IF_ERROR(status);
+            }
+
+            return this->redoIt();
+        }
+
+        if (this->cachedTables != nullptr)
+        {
+            return this->redoIt();
+        }
+
         meshSymmetryData.initialize(selectedMesh);
+
+        if (this->automatic || this->geometric || this->fillGaps)
+        {
+            status = this->getMeshPoints();
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+
+        if (this->automatic && !this->geometric)
+        {
+            status = this->findSymmetrySeeds();
+            RETURN_IF_ERROR(status);
+        }
     }
 
     return this->redoIt();
@@ -156,6 +212,16 @@ MStatus PolySymmetryCommand::doQueryMeshAction()
 
     if (this->isQueryExists)
     {
+        // Tables in the disk cache count, since commands use them without a node.
+        if (!cacheHit)
+        {
+            PolySymmetryCacheKey key;
+            PolySymmetryCache::getCacheKeyFromMesh(this->selectedMesh, key, kTopologyChecksum);
+
+            SymmetryCacheFile file;
+            cacheHit = PolySymmetryDiskCache::read(key, file);
+        }
+
         this->setResult(cacheHit);
     } else {
         if (cacheHit)
@@ -178,14 +244,35 @@ MStatus PolySymmetryCommand::doUndoableCommand()
 {
     MStatus status;
 
-    status = this->getSymmetricalComponentsFromScene();
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (this->linkToExistingNode)
+    {
+        return this->doLinkAction();
+    }
+
+    if (this->cachedTables != nullptr)
+    {
+        this->getSymmetricalComponentsFromTables(this->cachedTables);
+    } else {
+        status = this->getSymmetricalComponentsFromScene();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
 
     if (constructionHistory)
     {
         status = this->createResultNode();
         CHECK_MSTATUS_AND_RETURN_IT(status);
-        
+
+        // Deleting the node on undo also removes the link.
+        if (this->shared)
+        {
+            MDGModifier dgModifier;
+
+            status = this->linkMesh(dgModifier);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            status = dgModifier.doIt();
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
     } else {
         this->createResultString();
     }
@@ -194,10 +281,43 @@ MStatus PolySymmetryCommand::doUndoableCommand()
 }
 
 
+/*
+    In -shared mode, a mesh whose topology already has a polySymmetryData 
+    node is linked to that node instead of being solved again.
+*/
+MStatus PolySymmetryCommand::doLinkAction()
+{
+    MStatus status;
+
+    if (!this->constructionHistory)
+    {
+        status = this->getSymmetricalComponentsFromNode();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        this->createResultString();
+
+        return MStatus::kSuccess;
+    }
+
+    status = this->linkModifier.doIt();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MString resultName = MFnDependencyNode(this->meshSymmetryNode).name();
+    this->setResult(resultName);
+
+    return MStatus::kSuccess;
+}
+
+
 MStatus PolySymmetryCommand::undoIt()
 {
     MStatus status;
 
+    if (this->linkToExistingNode)
+    {
+        return this->linkModifier.undoIt();
+    }
+
     MDGModifier dgModifier;
 
     dgModifier.deleteNode(this->meshSymmetryNode);
@@ -211,6 +331,11 @@ MStatus PolySymmetryCommand::undoIt()
 
 const bool PolySymmetryCommand::isUndoable()
 {
+    if (this->linkToExistingNode) 
+    { 
+        return this->constructionHistory; 
+    }
+
     return !this->meshSymmetryNode.isNull();
 }
 
@@ -270,9 +395,46 @@ MStatus PolySymmetryCommand::parseArguments(MArgDatabase &argsData)
         constructionHistory = true;
     }
 
+    this->verbose = argsData.isFlagSet(VERBOSE_FLAG);
+    this->automatic = argsData.isFlagSet(AUTOMATIC_FLAG);
+    this->geometric = argsData.isFlagSet(GEOMETRIC_FLAG);
+    this->fillGaps = argsData.isFlagSet(FILL_GAPS_FLAG);
+    this->shared = argsData.isFlagSet(SHARED_FLAG);
+    this->faceWalk = argsData.isFlagSet(FACE_WALK_FLAG);
+
+    if (argsData.isFlagSet(TOLERANCE_FLAG))
+    {
+        status = argsData.getFlagArgument(TOLERANCE_FLAG, 0, this->tolerance);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argsData.isFlagSet(TIME_LIMIT_FLAG))
+    {
+        status = argsData.getFlagArgument(TIME_LIMIT_FLAG, 0, this->timeLimit);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (this->tolerance <= 0.0)
+    {
+        MGlobal::displayError("The -tolerance flag must be greater than zero.");
+        return MStatus::kFailure;
+    }
+
     status = this->getSelectedMesh(argsData);
     RETURN_IF_ERROR(status);
 
+    if (this->linkToExistingNode || this->cachedTables != nullptr)
+    {
+        return MStatus::kSuccess;
+    }
+
+    // In automatic mode the seeds are found once the mesh has been unpacked, 
+    // and the geometric solver does not use seeds at all.
+    if (this->automatic || this->geometric)
+    {
+        return MStatus::kSuccess;
+    }
+
     status = this->getSymmetryComponents(argsData);
     RETURN_IF_ERROR(status);
 
@@ -299,7 +461,23 @@ MStatus PolySymmetryCommand::getSelectedMesh(MArgDatabase &argsData)
         return MStatus::kFailure;
     }
 
-    meshData.unpackMesh(selectedMesh);
+    // A mesh linked to an existing node is not solved, so it is not unpacked.
+    if (this->shared)
+    {
+        this->linkToExistingNode = PolySymmetryCache::getNodeFromCache(selectedMesh, meshSymmetryNode);
+
+        // Tables from the disk cache are not solved again, but the node is 
+        // still created by this command, so that it can be undone.
+        if (!this->linkToExistingNode)
+        {
+            PolySymmetryCache::getTablesFromDiskCache(selectedMesh, this->cachedTablesData, this->cachedTables, this->cachedKey);
+        }
+    }
+
+    if (!this->linkToExistingNode && this->cachedTables == nullptr)
+    {
+        meshData.unpackMesh(selectedMesh);
+    }
 
     if (selectedMesh.node().hasFn(MFn::kMesh)) 
     {
@@ -429,45 +607,174 @@ MStatus PolySymmetryCommand::getFlagStringArguments(MArgList &args, MSelectionLi
 }
 
 
-MStatus PolySymmetryCommand::getSymmetricalComponentsFromNode()
+MStatus PolySymmetryCommand::getMeshPoints()
 {
     MStatus status;
-    MFnDependencyNode fnNode(this->meshSymmetryNode);
 
-    status = PolySymmetryNode::getValues(fnNode, EDGE_SYMMETRY, this->meshSymmetryData.edgeSymmetryIndices);
+    MFnMesh fnMesh(this->selectedMesh, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::getValues(fnNode, FACE_SYMMETRY, this->meshSymmetryData.faceSymmetryIndices);
+    status = fnMesh.getPoints(this->meshPoints, MSpace::kObject);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, this->meshSymmetryData.vertexSymmetryIndices);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    return MStatus::kSuccess;
+}
 
-    status = PolySymmetryNode::getValues(fnNode, EDGE_SIDES, this->meshSymmetryData.edgeSides);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::getValues(fnNode, FACE_SIDES, this->meshSymmetryData.faceSides);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+/*
+    Finds a seed for each shell of the selected mesh from its rest positions, 
+    in place of the -symmetry and -leftSideVertex flags.
+*/
+MStatus PolySymmetryCommand::findSymmetrySeeds()
+{
+    auto startTime = chrono::steady_clock::now();
+
+    int numberOfUnsolvedShells = this->meshSymmetryData.findSymmetrySeeds(
+        this->meshPoints, 
+        this->tolerance, 
+        this->timeLimit, 
+        this->symmetryComponents, 
+        this->leftSideVertexIndices
+    );
+
+    auto seedsTime = chrono::steady_clock::now();
+
+    if (this->symmetryComponents.empty())
+    {
+        MString errorMsg("Could not find the symmetry of ^1s. Check that it is symmetrical across the YZ plane within the tolerance, or select the symmetrical components.");
+        errorMsg.format(errorMsg, this->selectedMesh.partialPathName());
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
 
-    status = PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, this->meshSymmetryData.vertexSides);
+    if (numberOfUnsolvedShells > 0)
+    {
+        MString numberOfShells;
+        numberOfShells += numberOfUnsolvedShells;
+
+        MString warningMsg("Could not find the symmetry of ^1s shell(s) on ^2s. Their components are not symmetrical.");
+        warningMsg.format(warningMsg, numberOfShells, this->selectedMesh.partialPathName());
+
+        MGlobal::displayWarning(warningMsg);
+    }
+
+    if (this->verbose)
+    {
+        MString seedsMs;
+        seedsMs += chrono::duration<double, milli>(seedsTime - startTime).count();
+
+        MString infoMsg("polySymmetry: seeds ^1s ms.");
+        infoMsg.format(infoMsg, seedsMs);
+
+        MGlobal::displayInfo(infoMsg);
+    }
+
+    return MStatus::kSuccess;
+}
+
+
+MStatus PolySymmetryCommand::getSymmetricalComponentsFromNode()
+{
+    MStatus status;
+    MFnDependencyNode fnNode(this->meshSymmetryNode);
+
+    MObject tablesData;
+    const PolySymmetryTables* tables;
+
+    status = PolySymmetryNode::getTables(fnNode, tablesData, tables);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    this->getSymmetricalComponentsFromTables(tables);
+
     return MStatus::kSuccess;
 }
 
 
+void PolySymmetryCommand::getSymmetricalComponentsFromTables(const PolySymmetryTables* tables)
+{
+    PolySymmetryData &data = this->meshSymmetryData;
+
+    data.edgeSymmetryIndices.assign(tables->edgeSymmetry(), tables->edgeSymmetry() + tables->numberOfEdges());
+    data.faceSymmetryIndices.assign(tables->faceSymmetry(), tables->faceSymmetry() + tables->numberOfFaces());
+    data.vertexSymmetryIndices.assign(tables->vertexSymmetry(), tables->vertexSymmetry() + tables->numberOfVertices());
+
+    data.edgeSides.assign(tables->edgeSides(), tables->edgeSides() + tables->numberOfEdges());
+    data.faceSides.assign(tables->faceSides(), tables->faceSides() + tables->numberOfFaces());
+    data.vertexSides.assign(tables->vertexSides(), tables->vertexSides() + tables->numberOfVertices());
+}
+
+
 MStatus PolySymmetryCommand::getSymmetricalComponentsFromScene()
 {
     MStatus status;
 
-    for (ComponentSelection &s : symmetryComponents)
+    auto startTime = chrono::steady_clock::now();
+
+    if (this->geometric)
+    {
+        this->meshSymmetryData.findSymmetryByPosition(this->meshPoints, this->tolerance);
+    } else {
+        this->meshSymmetryData.findSymmetricalShells(symmetryComponents, this->faceWalk);
+    }
+
+    auto shellsTime = chrono::steady_clock::now();
+
+    if (this->fillGaps && !this->geometric)
+    {
+        int numberOfMatches = this->meshSymmetryData.fillSymmetryGaps(this->meshPoints, this->tolerance);
+
+        if (this->verbose)
+        {
+            MString gapsMs;
+            MString matches;
+
+            gapsMs += chrono::duration<double, milli>(chrono::steady_clock::now() - shellsTime).count();
+            matches += numberOfMatches;
+
+            MString infoMsg("polySymmetry: filled gaps in ^1s ms, ^2s vertices matched by position.");
+            infoMsg.format(infoMsg, gapsMs, matches);
+
+            MGlobal::displayInfo(infoMsg);
+        }
+
+        shellsTime = chrono::steady_clock::now();
+    }
+
+    // The geometric solver sets the vertex sides from the vertex positions.
+    if (!this->geometric)
     {
-        this->meshSymmetryData.findSymmetricalVertices(s);
+        this->meshSymmetryData.findVertexSides(leftSideVertexIndices);
     }
 
-    this->meshSymmetryData.findVertexSides(leftSideVertexIndices);
+    // The flood from the left side vertices does not reach shells that were only matched by position.
+    if (this->fillGaps && !this->geometric)
+    {
+        this->meshSymmetryData.findUnreachedVertexSides(this->meshPoints, this->tolerance);
+    }
+
+    auto sidesTime = chrono::steady_clock::now();
+
     this->meshSymmetryData.finalizeSymmetry();
 
+    auto finalizeTime = chrono::steady_clock::now();
+
+    if (this->verbose)
+    {
+        MString shellsMs;
+        MString sidesMs;
+        MString finalizeMs;
+
+        shellsMs += chrono::duration<double, milli>(shellsTime - startTime).count();
+        sidesMs += chrono::duration<double, milli>(sidesTime - shellsTime).count();
+        finalizeMs += chrono::duration<double, milli>(finalizeTime - sidesTime).count();
+
+        MString infoMsg("polySymmetry: shells ^1s ms, vertex sides ^2s ms, edge and face sides ^3s ms.");
+        infoMsg.format(infoMsg, shellsMs, sidesMs, finalizeMs);
+
+        MGlobal::displayInfo(infoMsg);
+    }
+
     return MStatus::kSuccess;
 }
 
@@ -492,41 +799,106 @@ MStatus PolySymmetryCommand::createResultNode()
 
     MFnDependencyNode fnNode(meshSymmetryNode);
 
-    status = PolySymmetryNode::setValues(fnNode, EDGE_SYMMETRY, this->meshSymmetryData.edgeSymmetryIndices);
+    status = PolySymmetryNode::setTables(fnNode, this->meshSymmetryData);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::setValues(fnNode, FACE_SYMMETRY, this->meshSymmetryData.faceSymmetryIndices);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    // Tables from the disk cache were found by the key of the mesh, so it 
+    // is not computed again.
+    PolySymmetryCacheKey key = this->cachedKey;
 
-    status = PolySymmetryNode::setValues(fnNode, VERTEX_SYMMETRY, this->meshSymmetryData.vertexSymmetryIndices);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (this->cachedTables == nullptr)
+    {
+        key.numberOfEdges = this->meshData.numberOfEdges;
+        key.numberOfFaces = this->meshData.numberOfFaces;
+        key.numberOfVertices = this->meshData.numberOfVertices;
+        key.checksumVersion = kTopologyChecksum;
+        key.vertexChecksum = MeshData::getVertexChecksum(this->selectedMesh, kTopologyChecksum);
+    }
 
-    status = PolySymmetryNode::setValues(fnNode, EDGE_SIDES, this->meshSymmetryData.edgeSides);
+    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_EDGES, key.numberOfEdges);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::setValues(fnNode, FACE_SIDES, this->meshSymmetryData.faceSides);
+    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_FACES, key.numberOfFaces);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::setValues(fnNode, VERTEX_SIDES, this->meshSymmetryData.vertexSides);
+    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_VERTICES, key.numberOfVertices);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_EDGES, this->meshData.numberOfEdges);
+    status = PolySymmetryNode::setValue(fnNode, CHECKSUM_VERSION, key.checksumVersion);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_FACES, this->meshData.numberOfFaces);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    uint64_t checksum = key.vertexChecksum;
 
-    status = PolySymmetryNode::setValue(fnNode, NUMBER_OF_VERTICES, this->meshData.numberOfVertices);
+    int vertexChecksum = (int) (uint32_t) checksum;
+    status = PolySymmetryNode::setValue(fnNode, VERTEX_CHECKSUM, vertexChecksum);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    int vertexChecksum = (int) MeshData::getVertexChecksum(this->selectedMesh);
-    status = PolySymmetryNode::setValue(fnNode, VERTEX_CHECKSUM, vertexChecksum);
+    int vertexChecksumHigh = (int) (uint32_t) (checksum >> 32);
+    status = PolySymmetryNode::setValue(fnNode, VERTEX_CHECKSUM_HIGH, vertexChecksumHigh);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
     this->setResult(fnNode.name());
 
     PolySymmetryCache::addNodeToCache(meshSymmetryNode);
 
+    if (this->cachedTables == nullptr)
+    {
+        PolySymmetryDiskCache::write(key, this->meshSymmetryData);
+    }
+
+    return MStatus::kSuccess;
+}
+
+
+/*
+    Connects the message of the mesh shape to the linkedMeshes of the node,
+    unless they are already connected. 
+*/
+MStatus PolySymmetryCommand::linkMesh(MDGModifier &dgModifier)
+{
+    MStatus status;
+
+    MDagPath shapePath(this->selectedMesh);
+
+    status = shapePath.extendToShape();
+
+    if (!status)
+    {
+        MString errorMsg("Cannot link ^1s to ^2s because it does not have exactly one shape.");
+        errorMsg.format(errorMsg, this->selectedMesh.partialPathName(), MFnDependencyNode(this->meshSymmetryNode).name());
+
+        MGlobal::displayError(errorMsg);
+        return MStatus::kFailure;
+    }
+
+    MFnDependencyNode fnShape(shapePath.node());
+
+    MPlug messagePlug = fnShape.findPlug("message", false, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MPlugArray destinations;
+    messagePlug.connectedTo(destinations, false, true);
+
+    for (unsigned i = 0; i < destinations.length(); i++)
+    {
+        if (destinations[i].node() == this->meshSymmetryNode) { return MStatus::kSuccess; }
+    }
+
+    MPlug linkedMeshesPlug(this->meshSymmetryNode, PolySymmetryNode::linkedMeshes);
+
+    MIntArray indices;
+    linkedMeshesPlug.getExistingArrayAttributeIndices(indices);
+
+    unsigned nextIndex = 0;
+
+    for (unsigned i = 0; i < indices.length(); i++)
+    {
+        nextIndex = max(nextIndex, (unsigned) indices[i] + 1);
+    }
+
+    status = dgModifier.connect(messagePlug, linkedMeshesPlug.elementByLogicalIndex(nextIndex));
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     return MStatus::kSuccess;
 }
 
@@ -586,12 +958,44 @@ void PolySymmetryCommand::setJSONData(const char* key, stringstream &output, vec
 }
 
 
+void PolySymmetryCommand::setJSONData(const char* key, stringstream &output, vector<int8_t> &data, bool isLast)
+{
+    vector<int> values(data.begin(), data.end());
+
+    setJSONData(key, output, values, isLast);
+}
+
+
 MStatus PolySymmetryCommand::finalize()
 {
     MArgList command;
 
     command.addArg(commandString());
 
+    // Every solve option is journaled, so the command replays the solve that was run.
+    // Seeds found by -automatic are journaled instead of the flag, since the 
+    // time limited search may not find the same seeds again.
+    bool hasFoundSeeds = this->automatic && !this->geometric;
+
+    command.addArg(CONSTRUCTION_HISTORY_FLAG);
+    command.addArg(this->constructionHistory);
+
+    if (this->verbose)                      { command.addArg(VERBOSE_FLAG); }
+    if (this->automatic && !hasFoundSeeds)  { command.addArg(AUTOMATIC_FLAG); }
+    if (this->geometric)                    { command.addArg(GEOMETRIC_FLAG); }
+    if (this->fillGaps)                     { command.addArg(FILL_GAPS_FLAG); }
+    if (this->shared)                       { command.addArg(SHARED_FLAG); }
+    if (this->faceWalk)                     { command.addArg(FACE_WALK_FLAG); }
+
+    command.addArg(TOLERANCE_FLAG);
+    command.addArg(this->tolerance);
+
+    if (!hasFoundSeeds)
+    {
+        command.addArg(TIME_LIMIT_FLAG);
+        command.addArg(this->timeLimit);
+    }
+
     for (ComponentSelection &cs : symmetryComponents)
     {
         command.addArg(SYMMETRY_COMPONENTS_FLAG);
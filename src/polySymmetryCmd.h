@@ -8,11 +8,16 @@
 
 #include "meshData.h"
 #include "polySymmetry.h"
+#include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 
+#include <cstdint>
 #include <vector>
 
 #include <maya/MArgList.h>
 #include <maya/MArgDatabase.h>
+#include <maya/MDGModifier.h>
+#include <maya/MPointArray.h>
 #include <maya/MPxToolCommand.h>
 #include <maya/MSelectionList.h>
 #include <maya/MString.h>
@@ -33,6 +38,30 @@ using namespace std;
 #define EXISTS_FLAG                     "-ex"
 #define EXISTS_LONG_FLAG                "-exists"
 
+#define VERBOSE_FLAG                    "-v"
+#define VERBOSE_LONG_FLAG               "-verbose"
+
+#define AUTOMATIC_FLAG                  "-a"
+#define AUTOMATIC_LONG_FLAG             "-auto"
+
+#define TOLERANCE_FLAG                  "-tol"
+#define TOLERANCE_LONG_FLAG             "-tolerance"
+
+#define TIME_LIMIT_FLAG                 "-tl"
+#define TIME_LIMIT_LONG_FLAG            "-timeLimit"
+
+#define GEOMETRIC_FLAG                  "-geo"
+#define GEOMETRIC_LONG_FLAG             "-geometric"
+
+#define FILL_GAPS_FLAG                  "-fg"
+#define FILL_GAPS_LONG_FLAG             "-fillGaps"
+
+#define SHARED_FLAG                     "-sh"
+#define SHARED_LONG_FLAG                "-shared"
+
+#define FACE_WALK_FLAG                  "-fw"
+#define FACE_WALK_LONG_FLAG             "-faceWalk"
+
 
 class PolySymmetryCommand : public MPxToolCommand
 {
@@ -50,6 +79,7 @@ public:
     virtual MStatus     doQueryDataAction();
     virtual MStatus     doQueryMeshAction();
     virtual MStatus     doUndoableCommand();
+    virtual MStatus     doLinkAction();
 
     virtual MStatus     parseQueryArguments(MArgDatabase &argsData);
     virtual MStatus     parseArguments(MArgDatabase &argsData);
@@ -64,10 +94,15 @@ public:
 
     virtual MStatus     getFlagStringArguments(MArgList &args, MSelectionList &selection);
 
+    virtual MStatus     getMeshPoints();
+    virtual MStatus     findSymmetrySeeds();
+
     virtual MStatus     getSymmetricalComponentsFromNode();
+    virtual void        getSymmetricalComponentsFromTables(const PolySymmetryTables* tables);
     virtual MStatus     getSymmetricalComponentsFromScene();
 
     virtual MStatus     createResultNode();
+    virtual MStatus     linkMesh(MDGModifier &dgModifier);
     virtual MStatus     createResultString();
 
     virtual MStatus     finalize();
@@ -76,6 +111,7 @@ public:
     const bool          hasSyntax()     { return true; } 
 
     static void         setJSONData(const char* key, stringstream &output, vector<int> &data, bool isLast=false);
+    static void         setJSONData(const char* key, stringstream &output, vector<int8_t> &data, bool isLast=false);
 
 public:
     static MString      COMMAND_NAME;
@@ -84,12 +120,29 @@ private:
     bool                        constructionHistory = false;
     bool                        isQuery = false;
     bool                        isQueryExists = false;
+    bool                        verbose = false;
+
+    bool                        automatic = false;
+    bool                        geometric = false;
+    bool                        fillGaps = false;
+    bool                        shared = false;
+    bool                        faceWalk = false;
+    bool                        linkToExistingNode = false;
+    double                      tolerance = 0.001;
+    double                      timeLimit = 10.0;
 
     MDagPath                    selectedMesh;
     MeshData                    meshData;
+    MPointArray                 meshPoints;
     PolySymmetryData            meshSymmetryData;
     
     MObject                     meshSymmetryNode;
+    MDGModifier                 linkModifier;
+
+    // Tables from the disk cache, used in -shared mode instead of a solve.
+    MObject                     cachedTablesData;
+    const PolySymmetryTables*   cachedTables = nullptr;
+    PolySymmetryCacheKey        cachedKey;
     
     vector<ComponentSelection>  symmetryComponents;
     vector<int>                 leftSideVertexIndices;
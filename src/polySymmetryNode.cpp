@@ -5,19 +5,26 @@
 
 #include "meshData.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
+#include "sceneCache.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 
 #include <maya/MDataBlock.h>
 #include <maya/MFnData.h>
 #include <maya/MFnIntArrayData.h>
 #include <maya/MFnMesh.h>
+#include <maya/MFnMessageAttribute.h>
 #include <maya/MFnNumericAttribute.h>
 #include <maya/MFnNumericData.h>
+#include <maya/MFnPluginData.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MGlobal.h>
 #include <maya/MIntArray.h>
 #include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
 #include <maya/MPxNode.h>
 #include <maya/MObject.h>
 #include <maya/MObjectHandle.h>
@@ -36,7 +43,13 @@ MObject PolySymmetryNode::edgeSides;
 MObject PolySymmetryNode::faceSides;
 MObject PolySymmetryNode::vertexSides;
 
+MObject PolySymmetryNode::symmetryTables;
+
 MObject PolySymmetryNode::vertexChecksum;
+MObject PolySymmetryNode::vertexChecksumHigh;
+MObject PolySymmetryNode::checksumVersion;
+
+MObject PolySymmetryNode::linkedMeshes;
 
 PolySymmetryNode::PolySymmetryNode() {}
 PolySymmetryNode::~PolySymmetryNode() {}
@@ -53,6 +66,7 @@ MStatus PolySymmetryNode::initialize()
 
     MFnTypedAttribute t;
     MFnNumericAttribute n;
+    MFnMessageAttribute m;
 
     numberOfEdges = n.create(NUMBER_OF_EDGES, "ne", MFnNumericData::kLong, -1, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
@@ -80,10 +94,29 @@ MStatus PolySymmetryNode::initialize()
 
     vertexSides = t.create(VERTEX_SIDES, "vs", MFnData::kIntArray, MObject::kNullObj, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    symmetryTables = t.create(SYMMETRY_TABLES, "sym", PolySymmetryTables::TYPE_ID, MObject::kNullObj, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
     
     vertexChecksum = n.create(VERTEX_CHECKSUM, "vc", MFnNumericData::kLong, -1, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    // The upper 32 bits of a 64-bit checksum. vertexChecksum holds the lower 32.
+    vertexChecksumHigh = n.create(VERTEX_CHECKSUM_HIGH, "vch", MFnNumericData::kLong, 0, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Nodes saved before this attribute existed read the default, which is 
+    // the version their checksum was computed with.
+    checksumVersion = n.create(CHECKSUM_VERSION, "cvn", MFnNumericData::kLong, kVertexRingChecksum, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // The meshes that share this node through polySymmetry -shared.
+    linkedMeshes = m.create(LINKED_MESHES, "lm", &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    m.setArray(true);
+    m.setIndexMatters(false);
+
     addAttribute(numberOfEdges);
     addAttribute(numberOfFaces);
     addAttribute(numberOfVertices);
@@ -96,7 +129,13 @@ MStatus PolySymmetryNode::initialize()
     addAttribute(faceSides);
     addAttribute(vertexSides);
 
+    addAttribute(symmetryTables);
+
     addAttribute(vertexChecksum);
+    addAttribute(vertexChecksumHigh);
+    addAttribute(checksumVersion);
+
+    addAttribute(linkedMeshes);
 
     return MStatus::kSuccess;    
 }
@@ -108,6 +147,26 @@ MStatus PolySymmetryNode::compute(const MPlug &plug, MDataBlock &dataBlock)
 }
 
 
+MStatus PolySymmetryNode::setDependentsDirty(const MPlug &plug, MPlugArray &affectedPlugs)
+{
+    bool isTables = plug == PolySymmetryNode::symmetryTables
+        || plug == PolySymmetryNode::edgeSymmetry
+        || plug == PolySymmetryNode::faceSymmetry
+        || plug == PolySymmetryNode::vertexSymmetry
+        || plug == PolySymmetryNode::edgeSides
+        || plug == PolySymmetryNode::faceSides
+        || plug == PolySymmetryNode::vertexSides;
+
+    if (isTables)
+    {
+        MObject node = this->thisMObject();
+        PolySymmetryCache::removeTablesFromCache(node);
+    }
+
+    return MPxNode::setDependentsDirty(plug, affectedPlugs);
+}
+
+
 MStatus PolySymmetryNode::setValue(MFnDependencyNode &fnNode, const char* attributeName, int &value)
 {
     MStatus status;
@@ -189,55 +248,386 @@ MStatus PolySymmetryNode::getValues(MFnDependencyNode &fnNode, const char* attri
 }
 
 
-MStatus PolySymmetryNode::getCacheKey(MObject &node, string &key)
+/*
+    Side tables are stored as int8_t, but written to the node as int arrays 
+    so that existing nodes and scripts read them the same way.
+*/
+MStatus PolySymmetryNode::setValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int8_t> &values)
 {
     MStatus status;
-    
-    int numberOfEdges;
-    int numberOfFaces;
-    int numberOfVertices;
-    int vertexChecksum;
 
-    MFnDependencyNode fnNode(node);
+    MPlug plug = fnNode.findPlug(attributeName, false, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    uint numberOfValues = (uint) values.size();
+    MIntArray valueArray(numberOfValues);
+
+    for (uint i = 0; i < numberOfValues; i++)
+    { 
+        valueArray[i] = (int) values[i];
+    }
+
+    MFnIntArrayData valueArrayData;
+
+    MObject data = valueArrayData.create(valueArray, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = plug.setMObject(data);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MStatus::kSuccess;
+}
+
+
+MStatus PolySymmetryNode::getValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int8_t> &values)
+{
+    MStatus status;
+
+    MPlug plug = fnNode.findPlug(attributeName, true, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObject data = plug.asMObject();
+
+    MFnIntArrayData valueArrayData(data, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    PolySymmetryNode::getValue(fnNode, NUMBER_OF_EDGES, numberOfEdges);
-    PolySymmetryNode::getValue(fnNode, NUMBER_OF_FACES, numberOfFaces);
-    PolySymmetryNode::getValue(fnNode, NUMBER_OF_VERTICES, numberOfVertices);
-    PolySymmetryNode::getValue(fnNode, VERTEX_CHECKSUM, vertexChecksum);
+    MIntArray valueArray = valueArrayData.array(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    if (numberOfEdges == -1 || numberOfFaces == -1 || numberOfVertices == -1 || vertexChecksum == -1)
+    uint numberOfValues = valueArray.length();
+    values.resize((int) numberOfValues);
+
+    for (uint i = 0; i < numberOfValues; i++)
     {
-        MString cacheErrorMessage("Cannot cache ^1s because it has incomplete data. Delete it and try again.");
-        cacheErrorMessage.format(cacheErrorMessage, fnNode.name());
-
-        MGlobal::displayWarning(cacheErrorMessage);
-    } else {
-        key = to_string(numberOfEdges) + ":" + 
-              to_string(numberOfFaces) + ":" + 
-              to_string(numberOfVertices) + ":" + 
-              to_string(vertexChecksum);
+        values[i] = (int8_t) valueArray[i];
     }
 
     return MStatus::kSuccess;
 }
 
 
-MStatus PolySymmetryNode::getCacheKeyFromMesh(MDagPath &dagPath, string &key)
+bool PolySymmetryCacheKey::operator==(const PolySymmetryCacheKey &other) const
+{
+    return vertexChecksum == other.vertexChecksum
+        && numberOfVertices == other.numberOfVertices
+        && numberOfEdges == other.numberOfEdges
+        && numberOfFaces == other.numberOfFaces
+        && checksumVersion == other.checksumVersion;
+}
+
+
+/*
+    The checksum is already well mixed for kTopologyChecksum, but a 32-bit 
+    CRC only fills the lower half, so the counts are folded in and the 
+    result is mixed again.
+*/
+size_t PolySymmetryCacheKeyHash::operator()(const PolySymmetryCacheKey &key) const
+{
+    uint64_t h = key.vertexChecksum;
+
+    h ^= ((uint64_t) (uint32_t) key.numberOfVertices << 32) | (uint32_t) key.numberOfFaces;
+    h ^= ((uint64_t) (uint32_t) key.numberOfEdges << 8) + (uint64_t) key.checksumVersion;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return (size_t) h;
+}
+
+
+MStatus PolySymmetryNode::newTables(MObject &tablesData, PolySymmetryTables* &tables)
+{
+    MStatus status;
+
+    MFnPluginData fnData;
+
+    tablesData = fnData.create(PolySymmetryTables::TYPE_ID, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    tables = (PolySymmetryTables*) fnData.data(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MStatus::kSuccess;
+}
+
+
+MStatus PolySymmetryNode::setTables(MFnDependencyNode &fnNode, MObject &tablesData)
+{
+    MStatus status;
+
+    MPlug plug = fnNode.findPlug(SYMMETRY_TABLES, false, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = plug.setMObject(tablesData);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MStatus::kSuccess;
+}
+
+
+MStatus PolySymmetryNode::setTables(MFnDependencyNode &fnNode, const PolySymmetryData &data)
+{
+    MStatus status;
+
+    MObject tablesData;
+    PolySymmetryTables* tables;
+
+    status = PolySymmetryNode::newTables(tablesData, tables);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    tables->setTables(data);
+
+    return PolySymmetryNode::setTables(fnNode, tablesData);
+}
+
+
+/*
+    Borrows the tables of the node. They belong to tablesData, which must 
+    be kept alive while the tables are used. Tables read from a scene file
+    are decoded the first time they are used, and kept in the tables cache
+    until the tables or the legacy arrays of the node change.
+*/
+MStatus PolySymmetryNode::getTables(MFnDependencyNode &fnNode, MObject &tablesData, const PolySymmetryTables* &tables)
+{
+    MStatus status;
+
+    MObject node = fnNode.object();
+
+    if (PolySymmetryCache::getTablesFromCache(node, tablesData, tables)) 
+    { 
+        return MStatus::kSuccess; 
+    }
+
+    status = PolySymmetryNode::readTables(fnNode, tablesData, tables);
+    if (!status) { return status; }
+
+    PolySymmetryCache::addTablesToCache(node, tablesData, tables);
+
+    return MStatus::kSuccess;
+}
+
+
+/*
+    Nodes saved before the tables attribute existed store them in six int 
+    array attributes. Those are read into tables that are not set on the 
+    node, so reading never edits the scene. A new solve writes the tables 
+    attribute instead.
+*/
+MStatus PolySymmetryNode::readTables(MFnDependencyNode &fnNode, MObject &tablesData, const PolySymmetryTables* &tables)
+{
+    MStatus status;
+
+    tables = nullptr;
+
+    MPlug plug = fnNode.findPlug(SYMMETRY_TABLES, true, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    tablesData = plug.asMObject();
+
+    if (!tablesData.isNull())
+    {
+        MFnPluginData fnData(tablesData, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        tables = (const PolySymmetryTables*) fnData.constData(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        if (!tables->empty()) 
+        { 
+            if (tables->decode()) { return MStatus::kSuccess; }
+
+            MString errorMsg("The symmetry tables on ^1s could not be decoded.");
+            errorMsg.format(errorMsg, fnNode.name());
+            MGlobal::displayError(errorMsg);
+
+            tables = nullptr;
+            return MStatus::kFailure;
+        }
+    }
+
+    PolySymmetryData legacyData;
+
+    status = PolySymmetryNode::getValues(fnNode, EDGE_SYMMETRY, legacyData.edgeSymmetryIndices);
+    if (!status) { return MStatus::kFailure; }
+
+    status = PolySymmetryNode::getValues(fnNode, FACE_SYMMETRY, legacyData.faceSymmetryIndices);
+    if (!status) { return MStatus::kFailure; }
+
+    status = PolySymmetryNode::getValues(fnNode, VERTEX_SYMMETRY, legacyData.vertexSymmetryIndices);
+    if (!status) { return MStatus::kFailure; }
+
+    status = PolySymmetryNode::getValues(fnNode, EDGE_SIDES, legacyData.edgeSides);
+    if (!status) { return MStatus::kFailure; }
+
+    status = PolySymmetryNode::getValues(fnNode, FACE_SIDES, legacyData.faceSides);
+    if (!status) { return MStatus::kFailure; }
+
+    status = PolySymmetryNode::getValues(fnNode, VERTEX_SIDES, legacyData.vertexSides);
+    if (!status) { return MStatus::kFailure; }
+
+    bool hasValidTables = legacyData.edgeSides.size() == legacyData.edgeSymmetryIndices.size()
+        && legacyData.faceSides.size() == legacyData.faceSymmetryIndices.size()
+        && legacyData.vertexSides.size() == legacyData.vertexSymmetryIndices.size();
+
+    if (!hasValidTables || legacyData.vertexSymmetryIndices.empty()) { return MStatus::kFailure; }
+
+    PolySymmetryTables* newTables;
+
+    status = PolySymmetryNode::newTables(tablesData, newTables);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    newTables->setTables(legacyData);
+
+    tables = newTables;
+
+    return MStatus::kSuccess;
+}
+
+
+/*
+    Reads the cache key of the node. This runs for every node in the scene 
+    when a file is opened, so it reads the key attributes directly and does 
+    not report anything. Returns kFailure, with an empty key, if the node 
+    has incomplete data.
+*/
+MStatus PolySymmetryNode::getCacheKey(MObject &node, PolySymmetryCacheKey &key)
+{
+    MStatus status;
+
+    key = PolySymmetryCacheKey();
+
+    MObject keyAttributes[] = {
+        PolySymmetryNode::numberOfEdges, 
+        PolySymmetryNode::numberOfFaces, 
+        PolySymmetryNode::numberOfVertices, 
+        PolySymmetryNode::vertexChecksum, 
+        PolySymmetryNode::vertexChecksumHigh, 
+        PolySymmetryNode::checksumVersion
+    };
+
+    int values[6];
+
+    for (int i = 0; i < 6; i++)
+    {
+        MPlug plug(node, keyAttributes[i]);
+
+        status = plug.getValue(values[i]);
+        if (!status) { return MStatus::kFailure; }
+    }
+
+    int numberOfEdges = values[0];
+    int numberOfFaces = values[1];
+    int numberOfVertices = values[2];
+    int vertexChecksum = values[3];
+    int vertexChecksumHigh = values[4];
+    int checksumVersion = values[5];
+
+    if (numberOfEdges == -1 || numberOfFaces == -1 || numberOfVertices == -1 || (vertexChecksum == -1 && checksumVersion == kVertexRingChecksum))
+    {
+        return MStatus::kFailure;
+    }
+
+    key.numberOfEdges = numberOfEdges;
+    key.numberOfFaces = numberOfFaces;
+    key.numberOfVertices = numberOfVertices;
+    key.checksumVersion = checksumVersion;
+    key.vertexChecksum = ((uint64_t) (uint32_t) vertexChecksumHigh << 32) | (uint32_t) vertexChecksum;
+
+    return MStatus::kSuccess;
+}
+
+
+/*
+    Keys from getCacheKeyFromMesh only match nodes created with the same 
+    checksum version, so the cache is searched once for each version in use.
+*/
+MStatus PolySymmetryNode::getCacheKeyFromMesh(MDagPath &dagPath, PolySymmetryCacheKey &key, ChecksumVersion version)
 {
     MStatus status;
     
     MFnMesh fnMesh(dagPath);
 
+    key.numberOfEdges = fnMesh.numEdges();
+    key.numberOfFaces = fnMesh.numPolygons();
+    key.numberOfVertices = fnMesh.numVertices();
+    key.checksumVersion = version;
+    key.vertexChecksum = MeshData::getVertexChecksum(dagPath, version);
+
+    return MStatus::kSuccess; 
+}
+
+
+/*
+    Checks that the symmetry tables of the node fit the mesh - the tables 
+    are the right size, and up to a few thousand evenly spaced edges are 
+    mirrored onto edges between the mirrored vertices. Used to tell apart 
+    nodes whose cache keys collide. Edges and vertices left unresolved (-1)
+    by a partial solve are skipped.
+*/
+bool PolySymmetryNode::verifyMesh(MObject &node, MDagPath &mesh)
+{
+    MStatus status;
+
+    MFnDependencyNode fnNode(node);
+    MFnMesh fnMesh(mesh);
+
+    MObject tablesData;
+    const PolySymmetryTables* tables;
+
+    status = PolySymmetryNode::getTables(fnNode, tablesData, tables);
+    if (!status || tables == nullptr) { return false; }
+
     int numberOfEdges = fnMesh.numEdges();
-    int numberOfFaces = fnMesh.numPolygons();
     int numberOfVertices = fnMesh.numVertices();
 
-    int vertexChecksum = (int) MeshData::getVertexChecksum(dagPath);
+    if (tables->numberOfEdges() != numberOfEdges || tables->numberOfVertices() != numberOfVertices)
+    {
+        return false;
+    }
 
-    key = to_string(numberOfEdges) + ":" 
-        + to_string(numberOfFaces) + ":" 
-        + to_string(numberOfVertices) + ":" 
-        + to_string(vertexChecksum);
+    const int* edgeSymmetry = tables->edgeSymmetry();
+    const int* vertexSymmetry = tables->vertexSymmetry();
 
-    return MStatus::kSuccess; 
+    int stride = max(1, numberOfEdges / 4096);
+
+    int2 edgeVertices;
+    int2 mirroredEdgeVertices;
+
+    for (int e = 0; e < numberOfEdges; e += stride)
+    {
+        int m = edgeSymmetry[e];
+
+        if (m == -1) { continue; }
+        if (m < 0 || m >= numberOfEdges) { return false; }
+
+        fnMesh.getEdgeVertices(e, edgeVertices);
+
+        int a = vertexSymmetry[edgeVertices[0]];
+        int b = vertexSymmetry[edgeVertices[1]];
+
+        if (a == -1 || b == -1) { continue; }
+
+        fnMesh.getEdgeVertices(m, mirroredEdgeVertices);
+
+        bool sameVertices = (a == mirroredEdgeVertices[0] && b == mirroredEdgeVertices[1]) 
+                         || (a == mirroredEdgeVertices[1] && b == mirroredEdgeVertices[0]);
+
+        if (!sameVertices) { return false; }
+    }
+
+    return true;
+}
+
+
+ChecksumVersion PolySymmetryNode::getChecksumVersion(MObject &node)
+{
+    int checksumVersion = kVertexRingChecksum;
+
+    MFnDependencyNode fnNode(node);
+    PolySymmetryNode::getValue(fnNode, CHECKSUM_VERSION, checksumVersion);
+
+    return (ChecksumVersion) checksumVersion;
 }
\ No newline at end of file
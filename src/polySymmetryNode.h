@@ -6,6 +6,10 @@
 #ifndef POLY_SYMMETRY_NODE_H
 #define POLY_SYMMETRY_NODE_H
 
+#include "meshData.h"
+#include "polySymmetryTables.h"
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -15,6 +19,7 @@
 #include <maya/MPxNode.h>
 #include <maya/MObject.h>
 #include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
 #include <maya/MString.h>
 #include <maya/MTypeId.h>
 
@@ -23,16 +28,43 @@
 #define NUMBER_OF_VERTICES "numberOfVertices"
 
 #define VERTEX_CHECKSUM "vertexChecksum"
+#define VERTEX_CHECKSUM_HIGH "vertexChecksumHigh"
+#define CHECKSUM_VERSION "checksumVersion"
 #define EDGE_SYMMETRY "edgeSymmetry"
 #define FACE_SYMMETRY "faceSymmetry"
 #define VERTEX_SYMMETRY "vertexSymmetry"
 
+#define SYMMETRY_TABLES "symmetryTables"
+
 #define EDGE_SIDES "edgeSides"
 #define FACE_SIDES "faceSides"
 #define VERTEX_SIDES "vertexSides"
 
+#define LINKED_MESHES "linkedMeshes"
+
 using namespace std;
 
+/*
+    Identifies the mesh a polySymmetryData node was created for. Nodes and 
+    meshes with equal keys are assumed to share a topology.
+*/
+struct PolySymmetryCacheKey
+{
+    int             numberOfEdges = -1;
+    int             numberOfFaces = -1;
+    int             numberOfVertices = -1;
+    int             checksumVersion = kVertexRingChecksum;
+    uint64_t        vertexChecksum = 0;
+
+    bool            empty() const   { return numberOfVertices == -1; }
+    bool            operator==(const PolySymmetryCacheKey &other) const;
+};
+
+struct PolySymmetryCacheKeyHash
+{
+    size_t operator()(const PolySymmetryCacheKey &key) const;
+};
+
 class PolySymmetryNode : MPxNode
 {
 public:
@@ -43,18 +75,34 @@ public:
     static  MStatus     initialize();
     
     virtual MStatus     compute(const MPlug &plug, MDataBlock &dataBlock);
+    virtual MStatus     setDependentsDirty(const MPlug &plug, MPlugArray &affectedPlugs);
 
     static MStatus      setValue(MFnDependencyNode &fnNode, const char* attributeName, int &value);
     static MStatus      getValue(MFnDependencyNode &fnNode, const char* attributeName, int &value);
 
     static MStatus      setValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int> &values);
     static MStatus      getValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int> &values);
+
+    static MStatus      setValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int8_t> &values);
+    static MStatus      getValues(MFnDependencyNode &fnNode, const char* attributeName, vector<int8_t> &values);
     
+    static MStatus      newTables(MObject &tablesData, PolySymmetryTables* &tables);
+    static MStatus      setTables(MFnDependencyNode &fnNode, MObject &tablesData);
+    static MStatus      setTables(MFnDependencyNode &fnNode, const PolySymmetryData &data);
+    static MStatus      getTables(MFnDependencyNode &fnNode, MObject &tablesData, const PolySymmetryTables* &tables);
+
     static MStatus      onInitializePlugin();
     static MStatus      onUninitializePlugin();
 
-    static MStatus      getCacheKey(MObject &node, string &key);
-    static MStatus      getCacheKeyFromMesh(MDagPath &node, string &key);
+    static MStatus      getCacheKey(MObject &node, PolySymmetryCacheKey &key);
+    static MStatus      getCacheKeyFromMesh(MDagPath &node, PolySymmetryCacheKey &key, ChecksumVersion version=kTopologyChecksum);
+
+    static bool         verifyMesh(MObject &node, MDagPath &mesh);
+
+    static ChecksumVersion getChecksumVersion(MObject &node);
+
+private:
+    static MStatus      readTables(MFnDependencyNode &fnNode, MObject &tablesData, const PolySymmetryTables* &tables);
 
 public:
     static MObject      numberOfEdges;
@@ -69,7 +117,13 @@ public:
     static MObject      faceSides;
     static MObject      vertexSides;
 
+    static MObject      symmetryTables;
+
     static MObject      vertexChecksum;
+    static MObject      vertexChecksumHigh;
+    static MObject      checksumVersion;
+
+    static MObject      linkedMeshes;
     
     static MString      NODE_NAME;
     static MTypeId      NODE_ID;
@@ -0,0 +1,689 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "polySymmetry.h"
+#include "polySymmetryTables.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <maya/MArgList.h>
+#include <maya/MPxData.h>
+#include <maya/MString.h>
+#include <maya/MStatus.h>
+#include <maya/MTypeId.h>
+
+using namespace std;
+
+/*
+    Scene files store the tables in an encoded form, tagged with a negative
+    first value so that the raw form - which starts with the number of edges -
+    can still be read.
+
+    The encoding is, in order:
+        - the number of edges, faces and vertices as varints.
+        - for each symmetry table, a 2-bit kind per component, followed by
+          the byte length of its values and the values. A component that is
+          its own mirror, or the second of a mirrored pair, has no value. The 
+          first of a pair stores the distance from the previous pair's mirror 
+          as a zigzag varint. Anything else is stored as a zigzag varint.
+        - for each side table, a format byte followed by the sides packed 
+          as 2-bit (side + 1), or as int8 if a side does not fit.
+
+    The ASCII form is the tag, the number of chunks, and the encoding as 
+    quoted base64 chunks.
+*/
+static const int ENCODED_TABLES_TAG = -1;
+static const size_t ASCII_CHUNK_SIZE = 4096;
+
+enum SymmetryKind { kSelfSymmetry = 0, kFirstOfPair, kSecondOfPair, kExplicitSymmetry };
+enum SidesFormat { kPackedSides = 0, kRawSides };
+
+static const char BASE64_CHARACTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void writeVarint(vector<uint8_t> &bytes, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+
+    bytes.push_back((uint8_t) value);
+}
+
+static uint32_t zigzag(int value)
+{
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static int unzigzag(uint32_t value)
+{
+    return (int) (value >> 1) ^ -(int) (value & 1);
+}
+
+/*
+    Reads the encoding. Every read is bounds checked, since the bytes come 
+    from a file; a read past the end sets failed and returns zeros.
+*/
+struct EncodedReader
+{
+    const uint8_t*  data;
+    size_t          size;
+    size_t          position = 0;
+    bool            failed = false;
+
+    EncodedReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint32_t readVarint()
+    {
+        uint32_t value = 0;
+
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (position >= size) { break; }
+
+            uint8_t byte = data[position++];
+            value |= (uint32_t) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) { return value; }
+        }
+
+        failed = true;
+        return 0;
+    }
+
+    const uint8_t* readBytes(size_t count)
+    {
+        if (failed || count > size - position) 
+        { 
+            failed = true; 
+            return nullptr; 
+        }
+
+        const uint8_t* result = data + position;
+        position += count;
+        return result;
+    }
+};
+
+static bool readCounts(EncodedReader &reader, int counts[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        uint32_t count = reader.readVarint();
+
+        if (reader.failed || count > (uint32_t) INT32_MAX / 4) { return false; }
+
+        counts[i] = (int) count;
+    }
+
+    return (int64_t) counts[0] + counts[1] + counts[2] <= INT32_MAX / 4;
+}
+
+static void encodeSymmetry(vector<uint8_t> &bytes, const int* symmetry, int n)
+{
+    vector<uint8_t> kinds((n + 3) / 4, 0);
+    vector<uint8_t> values;
+    values.reserve(n);
+
+    int previous = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        int s = symmetry[i];
+        uint8_t kind;
+
+        if (s == i)
+        {
+            kind = kSelfSymmetry;
+        } else if (s > i && s < n && symmetry[s] == i) {
+            kind = kFirstOfPair;
+            writeVarint(values, zigzag(s - previous));
+            previous = s;
+        } else if (s >= 0 && s < i && symmetry[s] == i) {
+            kind = kSecondOfPair;
+        } else {
+            kind = kExplicitSymmetry;
+            writeVarint(values, zigzag(s));
+        }
+
+        kinds[i / 4] |= kind << ((i % 4) * 2);
+    }
+
+    bytes.insert(bytes.end(), kinds.begin(), kinds.end());
+    writeVarint(bytes, (uint32_t) values.size());
+    bytes.insert(bytes.end(), values.begin(), values.end());
+}
+
+static bool decodeSymmetry(EncodedReader &reader, int* symmetry, int n)
+{
+    const uint8_t* kinds = reader.readBytes((n + 3) / 4);
+    uint32_t valuesSize = reader.readVarint();
+    const uint8_t* valuesData = reader.readBytes(valuesSize);
+
+    if (reader.failed) { return false; }
+
+    EncodedReader values(valuesData, valuesSize);
+
+    int previous = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        int kind = (kinds[i / 4] >> ((i % 4) * 2)) & 3;
+
+        if (kind == kSelfSymmetry)
+        {
+            symmetry[i] = i;
+        } else if (kind == kFirstOfPair) {
+            int s = previous + unzigzag(values.readVarint());
+
+            if (values.failed || s <= i || s >= n) { return false; }
+
+            symmetry[i] = s;
+            symmetry[s] = i;
+            previous = s;
+        } else if (kind == kSecondOfPair) {
+            int s = symmetry[i];
+
+            if (s < 0 || s >= i || symmetry[s] != i) { return false; }
+        } else {
+            symmetry[i] = unzigzag(values.readVarint());
+
+            if (values.failed) { return false; }
+        }
+    }
+
+    return values.position == values.size;
+}
+
+static void encodeSides(vector<uint8_t> &bytes, const int8_t* sides, int n)
+{
+    bool canPack = all_of(sides, sides + n, [](int8_t side) { return side >= -1 && side <= 2; });
+
+    if (!canPack)
+    {
+        bytes.push_back(kRawSides);
+        bytes.insert(bytes.end(), (const uint8_t*) sides, (const uint8_t*) sides + n);
+        return;
+    }
+
+    bytes.push_back(kPackedSides);
+
+    size_t start = bytes.size();
+    bytes.resize(start + (n + 3) / 4, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        bytes[start + i / 4] |= (uint8_t) (sides[i] + 1) << ((i % 4) * 2);
+    }
+}
+
+static bool decodeSides(EncodedReader &reader, int8_t* sides, int n)
+{
+    const uint8_t* format = reader.readBytes(1);
+
+    if (reader.failed) { return false; }
+
+    if (*format == kRawSides)
+    {
+        const uint8_t* raw = reader.readBytes(n);
+        if (reader.failed) { return false; }
+
+        copy_n((const int8_t*) raw, n, sides);
+        return true;
+    }
+
+    if (*format != kPackedSides) { return false; }
+
+    const uint8_t* packed = reader.readBytes((n + 3) / 4);
+    if (reader.failed) { return false; }
+
+    for (int i = 0; i < n; i++)
+    {
+        sides[i] = (int8_t) ((packed[i / 4] >> ((i % 4) * 2)) & 3) - 1;
+    }
+
+    return true;
+}
+
+static void writeBase64(ostream &out, const uint8_t* bytes, size_t size)
+{
+    char quad[4];
+
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t block = (uint32_t) bytes[i] << 16;
+        if (i + 1 < size) { block |= (uint32_t) bytes[i + 1] << 8; }
+        if (i + 2 < size) { block |= (uint32_t) bytes[i + 2]; }
+
+        quad[0] = BASE64_CHARACTERS[(block >> 18) & 63];
+        quad[1] = BASE64_CHARACTERS[(block >> 12) & 63];
+        quad[2] = i + 1 < size ? BASE64_CHARACTERS[(block >> 6) & 63] : '=';
+        quad[3] = i + 2 < size ? BASE64_CHARACTERS[block & 63] : '=';
+
+        out.write(quad, 4);
+    }
+}
+
+static bool readBase64(const char* text, size_t length, vector<uint8_t> &bytes)
+{
+    static int8_t lookup[256];
+    static bool initialized = false;
+
+    if (!initialized)
+    {
+        fill_n(lookup, 256, (int8_t) -1);
+
+        for (int i = 0; i < 64; i++) { lookup[(uint8_t) BASE64_CHARACTERS[i]] = (int8_t) i; }
+
+        initialized = true;
+    }
+
+    if (length % 4 != 0) { return false; }
+
+    for (size_t i = 0; i < length; i += 4)
+    {
+        int padding = (text[i + 3] == '=') + (text[i + 2] == '=');
+        uint32_t block = 0;
+
+        for (int j = 0; j < 4 - padding; j++)
+        {
+            int8_t value = lookup[(uint8_t) text[i + j]];
+            if (value < 0) { return false; }
+
+            block |= (uint32_t) value << (18 - 6 * j);
+        }
+
+        bytes.push_back((uint8_t) (block >> 16));
+        if (padding < 2) { bytes.push_back((uint8_t) (block >> 8)); }
+        if (padding < 1) { bytes.push_back((uint8_t) block); }
+    }
+
+    return true;
+}
+
+PolySymmetryTables::PolySymmetryTables() {}
+PolySymmetryTables::~PolySymmetryTables() {}
+
+void* PolySymmetryTables::creator()
+{
+    return new PolySymmetryTables();
+}
+
+MTypeId PolySymmetryTables::typeId() const
+{
+    return PolySymmetryTables::TYPE_ID;
+}
+
+MString PolySymmetryTables::name() const
+{
+    return PolySymmetryTables::TYPE_NAME;
+}
+
+void PolySymmetryTables::copy(const MPxData &other)
+{
+    const PolySymmetryTables &otherTables = (const PolySymmetryTables&) other;
+
+    _numberOfEdges = otherTables._numberOfEdges;
+    _numberOfFaces = otherTables._numberOfFaces;
+    _numberOfVertices = otherTables._numberOfVertices;
+
+    buffer = otherTables.buffer;
+    encoded = otherTables.encoded;
+
+    decodeOnce.reset(encoded.empty() ? nullptr : new once_flag());
+}
+
+/*
+    Sizes the buffer for the tables. The sides are packed four to an int
+    after the symmetry tables.
+*/
+void PolySymmetryTables::resize(int numberOfEdges, int numberOfFaces, int numberOfVertices)
+{
+    _numberOfEdges = numberOfEdges;
+    _numberOfFaces = numberOfFaces;
+    _numberOfVertices = numberOfVertices;
+
+    int n = this->numberOfComponents();
+
+    buffer.assign(n == 0 ? 0 : n + (n + 3) / 4, 0);
+    encoded.clear();
+    decodeOnce.reset();
+}
+
+void PolySymmetryTables::setTables(const PolySymmetryData &data)
+{
+    this->setTables(
+        (int) data.edgeSymmetryIndices.size(),
+        (int) data.faceSymmetryIndices.size(),
+        (int) data.vertexSymmetryIndices.size(),
+        data.edgeSymmetryIndices.data(),
+        data.faceSymmetryIndices.data(),
+        data.vertexSymmetryIndices.data(),
+        data.edgeSides.data(),
+        data.faceSides.data(),
+        data.vertexSides.data()
+    );
+}
+
+void PolySymmetryTables::setTables(
+    int numberOfEdges,
+    int numberOfFaces,
+    int numberOfVertices,
+    const int* edgeSymmetry,
+    const int* faceSymmetry,
+    const int* vertexSymmetry,
+    const int8_t* edgeSides,
+    const int8_t* faceSides,
+    const int8_t* vertexSides
+) {
+    this->resize(numberOfEdges, numberOfFaces, numberOfVertices);
+
+    if (this->empty()) { return; }
+
+    int* symmetry = buffer.data();
+
+    copy_n(edgeSymmetry, numberOfEdges, symmetry);
+    copy_n(faceSymmetry, numberOfFaces, symmetry + numberOfEdges);
+    copy_n(vertexSymmetry, numberOfVertices, symmetry + numberOfEdges + numberOfFaces);
+
+    int8_t* allSides = this->sides();
+
+    copy_n(edgeSides, numberOfEdges, allSides);
+    copy_n(faceSides, numberOfFaces, allSides + numberOfEdges);
+    copy_n(vertexSides, numberOfVertices, allSides + numberOfEdges + numberOfFaces);
+}
+
+void PolySymmetryTables::encode(vector<uint8_t> &bytes) const
+{
+    bytes.clear();
+
+    writeVarint(bytes, (uint32_t) _numberOfEdges);
+    writeVarint(bytes, (uint32_t) _numberOfFaces);
+    writeVarint(bytes, (uint32_t) _numberOfVertices);
+
+    if (buffer.empty()) { return; }
+
+    const int* symmetry = buffer.data();
+
+    encodeSymmetry(bytes, symmetry, _numberOfEdges);
+    encodeSymmetry(bytes, symmetry + _numberOfEdges, _numberOfFaces);
+    encodeSymmetry(bytes, symmetry + _numberOfEdges + _numberOfFaces, _numberOfVertices);
+
+    const int8_t* allSides = this->sides();
+
+    encodeSides(bytes, allSides, _numberOfEdges);
+    encodeSides(bytes, allSides + _numberOfEdges, _numberOfFaces);
+    encodeSides(bytes, allSides + _numberOfEdges + _numberOfFaces, _numberOfVertices);
+}
+
+/*
+    Returns the encoding to write. Tables that have not been decoded since 
+    they were read are written back as they were read.
+*/
+const vector<uint8_t>& PolySymmetryTables::getEncoded(vector<uint8_t> &scratch) const
+{
+    if (!encoded.empty()) { return encoded; }
+
+    this->encode(scratch);
+    return scratch;
+}
+
+/*
+    Takes the encoding read from a file. Only the counts are read here; the 
+    tables are decoded on first access.
+*/
+MStatus PolySymmetryTables::setEncoded(vector<uint8_t> &bytes)
+{
+    int counts[3];
+    EncodedReader reader(bytes.data(), bytes.size());
+
+    if (!readCounts(reader, counts)) 
+    { 
+        this->resize(0, 0, 0);
+        return MStatus::kFailure; 
+    }
+
+    this->resize(0, 0, 0);
+
+    _numberOfEdges = counts[0];
+    _numberOfFaces = counts[1];
+    _numberOfVertices = counts[2];
+
+    if (this->numberOfComponents() != 0) 
+    { 
+        encoded.swap(bytes); 
+        decodeOnce.reset(new once_flag());
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Decodes the tables if they were read from a file and not yet used. 
+    Returns false, and leaves the tables empty, if the encoding is invalid.
+*/
+bool PolySymmetryTables::decode() const
+{
+    if (decodeOnce) 
+    { 
+        call_once(*decodeOnce, [this]() { this->decodeEncoded(); }); 
+    }
+
+    return !buffer.empty() || this->numberOfComponents() == 0;
+}
+
+/*
+    Replaces the encoding with the decoded tables. Only called through
+    decodeOnce, so concurrent first reads wait for a single decode.
+*/
+void PolySymmetryTables::decodeEncoded() const
+{
+    int counts[3];
+    EncodedReader reader(encoded.data(), encoded.size());
+
+    readCounts(reader, counts);
+
+    int n = this->numberOfComponents();
+    buffer.assign(n + (n + 3) / 4, 0);
+
+    int* symmetry = buffer.data();
+    int8_t* allSides = (int8_t*) (buffer.data() + n);
+
+    bool isValid = decodeSymmetry(reader, symmetry, _numberOfEdges)
+        && decodeSymmetry(reader, symmetry + _numberOfEdges, _numberOfFaces)
+        && decodeSymmetry(reader, symmetry + _numberOfEdges + _numberOfFaces, _numberOfVertices)
+        && decodeSides(reader, allSides, _numberOfEdges)
+        && decodeSides(reader, allSides + _numberOfEdges, _numberOfFaces)
+        && decodeSides(reader, allSides + _numberOfEdges + _numberOfFaces, _numberOfVertices)
+        && reader.position == reader.size;
+
+    vector<uint8_t>().swap(encoded);
+
+    if (!isValid) { vector<int>().swap(buffer); }
+}
+
+MStatus PolySymmetryTables::readASCII(const MArgList &argList, unsigned &lastElement)
+{
+    MStatus status;
+
+    if (argList.length() < lastElement + 1) { return MStatus::kFailure; }
+
+    int tag = argList.asInt(lastElement, &status);
+
+    if (!status || tag != ENCODED_TABLES_TAG) 
+    { 
+        return this->readRawASCII(argList, lastElement); 
+    }
+
+    lastElement++;
+
+    if (argList.length() < lastElement + 1) { return MStatus::kFailure; }
+
+    int numberOfChunks = argList.asInt(lastElement++, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (numberOfChunks < 0 || argList.length() < lastElement + (unsigned) numberOfChunks) { return MStatus::kFailure; }
+
+    vector<uint8_t> bytes;
+
+    for (int i = 0; i < numberOfChunks; i++)
+    {
+        MString chunk = argList.asString(lastElement++, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        if (!readBase64(chunk.asChar(), (size_t) chunk.length(), bytes)) { return MStatus::kFailure; }
+    }
+
+    return this->setEncoded(bytes);
+}
+
+MStatus PolySymmetryTables::writeASCII(ostream &out)
+{
+    vector<uint8_t> scratch;
+    const vector<uint8_t> &bytes = this->getEncoded(scratch);
+
+    size_t chunkBytes = ASCII_CHUNK_SIZE / 4 * 3;
+    size_t numberOfChunks = (bytes.size() + chunkBytes - 1) / chunkBytes;
+
+    out << ENCODED_TABLES_TAG << " " << numberOfChunks;
+
+    for (size_t i = 0; i < bytes.size(); i += chunkBytes)
+    {
+        out << "\n\t\t\"";
+        writeBase64(out, bytes.data() + i, min(chunkBytes, bytes.size() - i));
+        out << "\"";
+    }
+
+    return out.fail() ? MStatus::kFailure : MStatus::kSuccess;
+}
+
+MStatus PolySymmetryTables::readBinary(istream &in, unsigned length)
+{
+    int32_t tag;
+
+    if (length < sizeof(tag)) { return MStatus::kFailure; }
+
+    in.read((char*) &tag, sizeof(tag));
+
+    if (in.fail()) { return MStatus::kFailure; }
+
+    // The raw form starts with the number of edges, so a value that is not 
+    // the tag is passed on rather than seeking back over it.
+    if (tag != ENCODED_TABLES_TAG)
+    {
+        return this->readRawBinary(in, length, tag);
+    }
+
+    vector<uint8_t> bytes(length - sizeof(tag));
+
+    in.read((char*) bytes.data(), bytes.size());
+
+    if (in.fail()) { return MStatus::kFailure; }
+
+    return this->setEncoded(bytes);
+}
+
+MStatus PolySymmetryTables::writeBinary(ostream &out)
+{
+    vector<uint8_t> scratch;
+    const vector<uint8_t> &bytes = this->getEncoded(scratch);
+
+    int32_t tag = ENCODED_TABLES_TAG;
+
+    out.write((const char*) &tag, sizeof(tag));
+    out.write((const char*) bytes.data(), bytes.size());
+
+    return out.fail() ? MStatus::kFailure : MStatus::kSuccess;
+}
+
+/*
+    The raw ASCII form is the three counts, then the edge, face and vertex
+    symmetry, then the edge, face and vertex sides.
+*/
+MStatus PolySymmetryTables::readRawASCII(const MArgList &argList, unsigned &lastElement)
+{
+    MStatus status;
+
+    if (argList.length() < lastElement + 3) { return MStatus::kFailure; }
+
+    int numberOfEdges = argList.asInt(lastElement++, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numberOfFaces = argList.asInt(lastElement++, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numberOfVertices = argList.asInt(lastElement++, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (numberOfEdges < 0 || numberOfFaces < 0 || numberOfVertices < 0) { return MStatus::kFailure; }
+
+    this->resize(numberOfEdges, numberOfFaces, numberOfVertices);
+
+    unsigned n = (unsigned) this->numberOfComponents();
+
+    if (argList.length() < lastElement + n * 2)
+    {
+        this->resize(0, 0, 0);
+        return MStatus::kFailure;
+    }
+
+    int* symmetry = buffer.data();
+    int8_t* allSides = this->sides();
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        symmetry[i] = argList.asInt(lastElement++);
+    }
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        allSides[i] = (int8_t) argList.asInt(lastElement++);
+    }
+
+    return MStatus::kSuccess;
+}
+
+/*
+    The raw binary form is the three counts as int32, followed by the buffer.
+    The number of edges has already been read by readBinary.
+*/
+MStatus PolySymmetryTables::readRawBinary(istream &in, unsigned length, int32_t numberOfEdges)
+{
+    int32_t counts[3] = {numberOfEdges, 0, 0};
+
+    if (length < sizeof(counts)) { return MStatus::kFailure; }
+
+    in.read((char*) (counts + 1), sizeof(counts) - sizeof(counts[0]));
+
+    if (in.fail() || counts[0] < 0 || counts[1] < 0 || counts[2] < 0) { return MStatus::kFailure; }
+
+    this->resize(counts[0], counts[1], counts[2]);
+
+    size_t bufferSize = buffer.size() * sizeof(int);
+
+    if ((size_t) length != sizeof(counts) + bufferSize)
+    {
+        this->resize(0, 0, 0);
+        return MStatus::kFailure;
+    }
+
+    in.read((char*) buffer.data(), bufferSize);
+
+    if (in.fail())
+    {
+        this->resize(0, 0, 0);
+        return MStatus::kFailure;
+    }
+
+    return MStatus::kSuccess;
+}
\ No newline at end of file
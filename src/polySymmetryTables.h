@@ -0,0 +1,114 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_TABLES_H
+#define POLY_SYMMETRY_TABLES_H
+
+#include "polySymmetry.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <maya/MArgList.h>
+#include <maya/MPxData.h>
+#include <maya/MString.h>
+#include <maya/MStatus.h>
+#include <maya/MTypeId.h>
+
+using namespace std;
+
+/*
+    The symmetry and side tables of a mesh, stored on a polySymmetryData node
+    as one attribute. The three symmetry tables and the three side tables
+    share one buffer - the symmetry as int32, followed by the sides as int8 -
+    so commands can borrow them by const pointer instead of copying them out
+    of six MIntArrays.
+
+    Scene files store the tables encoded (see polySymmetryTables.cpp). The
+    encoded bytes are kept as they were read and only decoded the first time
+    the tables are accessed, so opening a scene does not pay for nodes that
+    are never used. The decode runs once even if several threads access the
+    tables at the same time.
+*/
+class PolySymmetryTables : public MPxData
+{
+public:
+                        PolySymmetryTables();
+    virtual            ~PolySymmetryTables();
+
+    static void*        creator();
+
+    virtual MStatus     readASCII(const MArgList &argList, unsigned &lastElement);
+    virtual MStatus     readBinary(istream &in, unsigned length);
+    virtual MStatus     writeASCII(ostream &out);
+    virtual MStatus     writeBinary(ostream &out);
+
+    virtual void        copy(const MPxData &other);
+
+    virtual MTypeId     typeId() const;
+    virtual MString     name() const;
+
+    void                setTables(const PolySymmetryData &data);
+    void                setTables(
+                            int numberOfEdges,
+                            int numberOfFaces,
+                            int numberOfVertices,
+                            const int* edgeSymmetry,
+                            const int* faceSymmetry,
+                            const int* vertexSymmetry,
+                            const int8_t* edgeSides,
+                            const int8_t* faceSides,
+                            const int8_t* vertexSides
+                        );
+
+    bool                decode() const;
+
+    bool                empty() const               { return buffer.empty() && encoded.empty(); }
+
+    int                 numberOfEdges() const       { return _numberOfEdges; }
+    int                 numberOfFaces() const       { return _numberOfFaces; }
+    int                 numberOfVertices() const    { return _numberOfVertices; }
+
+    const int*          edgeSymmetry() const        { decode(); return buffer.data(); }
+    const int*          faceSymmetry() const        { decode(); return buffer.data() + _numberOfEdges; }
+    const int*          vertexSymmetry() const      { decode(); return buffer.data() + _numberOfEdges + _numberOfFaces; }
+
+    const int8_t*       edgeSides() const           { decode(); return sides(); }
+    const int8_t*       faceSides() const           { decode(); return sides() + _numberOfEdges; }
+    const int8_t*       vertexSides() const         { decode(); return sides() + _numberOfEdges + _numberOfFaces; }
+
+private:
+    void                resize(int numberOfEdges, int numberOfFaces, int numberOfVertices);
+
+    MStatus             readRawASCII(const MArgList &argList, unsigned &lastElement);
+    MStatus             readRawBinary(istream &in, unsigned length, int32_t numberOfEdges);
+    MStatus             setEncoded(vector<uint8_t> &bytes);
+    void                encode(vector<uint8_t> &bytes) const;
+    void                decodeEncoded() const;
+    const vector<uint8_t>& getEncoded(vector<uint8_t> &scratch) const;
+
+    int                 numberOfComponents() const  { return _numberOfEdges + _numberOfFaces + _numberOfVertices; }
+    const int8_t*       sides() const               { return (const int8_t*) (buffer.data() + numberOfComponents()); }
+    int8_t*             sides()                     { return (int8_t*) (buffer.data() + numberOfComponents()); }
+
+public:
+    static MString      TYPE_NAME;
+    static MTypeId      TYPE_ID;
+
+private:
+    int                 _numberOfEdges = 0;
+    int                 _numberOfFaces = 0;
+    int                 _numberOfVertices = 0;
+
+    mutable vector<int>     buffer;
+    mutable vector<uint8_t> encoded;
+    mutable unique_ptr<once_flag> decodeOnce;
+};
+
+#endif
\ No newline at end of file
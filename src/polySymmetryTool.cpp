@@ -281,10 +281,7 @@ void PolySymmetryTool::recalculateSymmetry()
 {
     if (!selectedMesh.isValid()) { return; }
 
-    for (ComponentSelection &s : selectedComponents)
-    {
-        this->symmetryData.findSymmetricalVertices(s);
-    }
+    this->symmetryData.findSymmetricalShells(selectedComponents);
 
     this->symmetryData.findVertexSides(this->leftSideVertexIndices);
 }
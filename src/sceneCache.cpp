@@ -7,30 +7,50 @@
 #include <unordered_map>
 #include <utility>
 
+#include "diskCache.h"
+#include "meshData.h"
 #include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
 #include "sceneCache.h"
 
 #include <maya/MCallbackIdArray.h>
+#include <maya/MDagPath.h>
 #include <maya/MDGMessage.h>
+#include <maya/MFn.h>
 #include <maya/MFnDependencyNode.h>
+#include <maya/MFnMesh.h>
+#include <maya/MGlobal.h>
 #include <maya/MItDependencyNodes.h>
 #include <maya/MMessage.h>
+#include <maya/MNodeMessage.h>
 #include <maya/MObject.h>
 #include <maya/MObjectHandle.h>
+#include <maya/MPlug.h>
+#include <maya/MPolyMessage.h>
 #include <maya/MSceneMessage.h>
 #include <maya/MStatus.h>
+#include <maya/MString.h>
 
 
-unordered_map<string, MObjectHandle>    PolySymmetryCache::symmetryNodeCache;
+unordered_multimap<PolySymmetryCacheKey, MObjectHandle, PolySymmetryCacheKeyHash>    PolySymmetryCache::symmetryNodeCache;
 MCallbackIdArray                        PolySymmetryCache::callbackIDs;
 bool                                    PolySymmetryCache::cacheNodes;
+int                                     PolySymmetryCache::vertexRingNodes = 0;
+
+unordered_map<MObjectHandle, MeshChecksumMemo, MObjectHandleHash>  PolySymmetryCache::meshChecksumMemo;
+
+unsigned int                            PolySymmetryCache::checksumHits = 0;
+unsigned int                            PolySymmetryCache::checksumMisses = 0;
+
+unordered_map<MObjectHandle, CachedSymmetryTables, MObjectHandleHash>  PolySymmetryCache::tablesCache;
 
 MStatus PolySymmetryCache::initialize() 
 {
     MStatus status;
 
     PolySymmetryCache::cacheNodes = true;
-    PolySymmetryCache::symmetryNodeCache = unordered_map<string, MObjectHandle>();
+    PolySymmetryCache::symmetryNodeCache = unordered_multimap<PolySymmetryCacheKey, MObjectHandle, PolySymmetryCacheKeyHash>();
+    PolySymmetryCache::vertexRingNodes = 0;
     PolySymmetryCache::callbackIDs = MCallbackIdArray();
 
     MCallbackId sceneUpdateCallbackId = MSceneMessage::addCallback(MSceneMessage::kSceneUpdate, PolySymmetryCache::sceneUpdateCallback, &status);
@@ -51,12 +71,16 @@ MStatus PolySymmetryCache::initialize()
     MCallbackId nodeRemovedCallbackId = MDGMessage::addNodeRemovedCallback(PolySymmetryCache::nodeRemovedCallback, PolySymmetryNode::NODE_NAME, NULL, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    MCallbackId meshRemovedCallbackId = MDGMessage::addNodeRemovedCallback(PolySymmetryCache::meshRemovedCallback, "mesh", NULL, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     callbackIDs.append(sceneUpdateCallbackId);
     callbackIDs.append(afterNewCallbackId);
     callbackIDs.append(beforeOpenCallbackId);
     callbackIDs.append(afterOpenCallbackId);
     callbackIDs.append(nodeAddedCallbackId);
     callbackIDs.append(nodeRemovedCallbackId);
+    callbackIDs.append(meshRemovedCallbackId);
 
     return MStatus::kSuccess;
 }
@@ -68,6 +92,9 @@ MStatus PolySymmetryCache::uninitialize()
     status = MMessage::removeCallbacks(callbackIDs);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    PolySymmetryCache::clearChecksumMemo();
+    PolySymmetryCache::tablesCache.clear();
+
     return MStatus::kSuccess;
 }
     
@@ -89,20 +116,46 @@ void PolySymmetryCache::nodeAddedCallback(MObject &node, void* clientData)
 
 void PolySymmetryCache::nodeRemovedCallback(MObject &node, void* clientData)
 {
+    PolySymmetryCache::removeTablesFromCache(node);
+
     if (!PolySymmetryCache::cacheNodes) { return; }
 
-    string key;
+    PolySymmetryCacheKey key;
     PolySymmetryNode::getCacheKey(node, key);
 
-    if (!key.empty() && PolySymmetryCache::symmetryNodeCache.count(key) > 0)
+    if (key.empty()) { return; }
+
+    MObjectHandle handle(node);
+    auto range = PolySymmetryCache::symmetryNodeCache.equal_range(key);
+
+    for (auto it = range.first; it != range.second; it++)
     {
-        PolySymmetryCache::symmetryNodeCache.erase(key);
+        if (it->second == handle)
+        {
+            PolySymmetryCache::symmetryNodeCache.erase(it);
+
+            if (key.checksumVersion == kVertexRingChecksum)
+            {
+                PolySymmetryCache::vertexRingNodes--;
+            }
+
+            break;
+        }
     }
 }
 
+void PolySymmetryCache::meshRemovedCallback(MObject &node, void* clientData)
+{
+    PolySymmetryCache::removeChecksumMemo(node);
+}
+
 void PolySymmetryCache::newFileCallback(void* clientData)
 {
     PolySymmetryCache::symmetryNodeCache.clear();
+    PolySymmetryCache::vertexRingNodes = 0;
+
+    PolySymmetryCache::clearChecksumMemo();
+    PolySymmetryCache::tablesCache.clear();
 }
 
 void PolySymmetryCache::beforeOpenFileCallback(void* clientData)
@@ -115,55 +168,309 @@ void PolySymmetryCache::afterOpenFileCallback(void* clientData)
     PolySymmetryCache::cacheNodes = true;
 
     PolySymmetryCache::symmetryNodeCache.clear();
+    PolySymmetryCache::vertexRingNodes = 0;
 
-    MItDependencyNodes itNodes;
+    PolySymmetryCache::clearChecksumMemo();
+    PolySymmetryCache::tablesCache.clear();
+
+    MItDependencyNodes itNodes(MFn::kPluginDependNode);
     MFnDependencyNode fnNode;
     MObject node;
 
+    int incompleteNodes = 0;
+
     while (!itNodes.isDone())
     {
         node = itNodes.thisNode();
 
         fnNode.setObject(node);
 
-        if (fnNode.typeName() == PolySymmetryNode::NODE_NAME)
+        if (fnNode.typeId() == PolySymmetryNode::NODE_ID && !PolySymmetryCache::addNodeToCache(node))
         {
-            PolySymmetryCache::addNodeToCache(node);
+            incompleteNodes++;
         }
 
         itNodes.next();
     }   
+
+    if (incompleteNodes > 0)
+    {
+        MString warningMsg("Cannot cache ^1s polySymmetryData node(s) because they have incomplete data. Delete them and try again.");
+        warningMsg.format(warningMsg, MString() + incompleteNodes);
+
+        MGlobal::displayWarning(warningMsg);
+    }
 }
 
-void PolySymmetryCache::addNodeToCache(MObject &node)
+/*
+    Adds the node to the cache by its key. Only the key attributes are read;
+    the tables are decoded when a command first uses the node. Returns false 
+    if the node has incomplete data.
+*/
+bool PolySymmetryCache::addNodeToCache(MObject &node)
 {
-    string key;
+    PolySymmetryCacheKey key;
     PolySymmetryNode::getCacheKey(node, key);
 
-    if (!key.empty())
+    if (key.empty()) { return false; }
+
+    MObjectHandle handle(node);
+    auto range = PolySymmetryCache::symmetryNodeCache.equal_range(key);
+
+    for (auto it = range.first; it != range.second; it++)
     {
-        MObjectHandle handle(node);
-        PolySymmetryCache::symmetryNodeCache.emplace(key, handle);
+        if (it->second == handle) { return true; }
     }
+
+    PolySymmetryCache::symmetryNodeCache.emplace(key, handle);
+
+    if (key.checksumVersion == kVertexRingChecksum)
+    {
+        PolySymmetryCache::vertexRingNodes++;
+    }
+
+    return true;
 }
 
 bool PolySymmetryCache::getNodeFromCache(MDagPath &mesh, MObject &node)
 {
     bool result = false;
 
-    string key;
-    PolySymmetryNode::getCacheKeyFromMesh(mesh, key);
+    ChecksumVersion versions[] = {kTopologyChecksum, kVertexRingChecksum};
 
-    if (!key.empty())
+    for (ChecksumVersion version : versions)
     {
-        auto got = PolySymmetryCache::symmetryNodeCache.find(key);
-        result = got != PolySymmetryCache::symmetryNodeCache.end();
+        if (version == kVertexRingChecksum && PolySymmetryCache::vertexRingNodes <= 0) 
+        { 
+            break; 
+        }
+
+        PolySymmetryCacheKey key;
+        PolySymmetryCache::getCacheKeyFromMesh(mesh, key, version);
+
+        if (key.empty()) { continue; }
 
-        if (result)
+        auto range = PolySymmetryCache::symmetryNodeCache.equal_range(key);
+
+        int numberOfCandidates = 0;
+
+        for (auto it = range.first; it != range.second; it++)
         {
-            node = (*got).second.object();
+            if (it->second.isValid()) { numberOfCandidates++; }
         }
+
+        // A single match is trusted. Colliding nodes are checked against the mesh.
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (!it->second.isValid()) { continue; }
+
+            MObject candidate = it->second.object();
+
+            if (numberOfCandidates == 1 || PolySymmetryNode::verifyMesh(candidate, mesh))
+            {
+                node = candidate;
+                result = true;
+                break;
+            }
+        }
+
+        if (result) { break; }
     }
 
     return result;
+}
+
+/*
+    Reads the tables of a mesh from the disk cache. The tables are not set 
+    on any node, so a lookup never edits the scene. Commands that need a 
+    node create it themselves, from the key the tables were found by.
+*/
+bool PolySymmetryCache::getTablesFromDiskCache(MDagPath &mesh, MObject &tablesData, const PolySymmetryTables* &tables, PolySymmetryCacheKey &key)
+{
+    MStatus status;
+
+    tables = nullptr;
+
+    if (!PolySymmetryDiskCache::isEnabled()) { return false; }
+
+    PolySymmetryCache::getCacheKeyFromMesh(mesh, key, kTopologyChecksum);
+
+    SymmetryCacheFile file;
+
+    if (!PolySymmetryDiskCache::read(key, file)) { return false; }
+
+    status = PolySymmetryDiskCache::createTables(key, file, tablesData, tables);
+
+    if (!status) 
+    { 
+        tables = nullptr;
+        return false; 
+    }
+
+    return true;
+}
+
+/*
+    Finds the tables of a mesh, from its polySymmetryData node if there is 
+    one in the scene and from the disk cache otherwise.
+*/
+bool PolySymmetryCache::getMeshTables(MDagPath &mesh, MObject &tablesData, const PolySymmetryTables* &tables)
+{
+    MObject node;
+
+    tables = nullptr;
+
+    if (PolySymmetryCache::getNodeFromCache(mesh, node))
+    {
+        MFnDependencyNode fnNode(node);
+
+        if (PolySymmetryNode::getTables(fnNode, tablesData, tables)) { return true; }
+    }
+
+    PolySymmetryCacheKey key;
+
+    return PolySymmetryCache::getTablesFromDiskCache(mesh, tablesData, tables, key);
+}
+
+/*
+    Memoized PolySymmetryNode::getCacheKeyFromMesh. The key of a shape is 
+    computed once per checksum version, and kept until a callback on the 
+    shape reports that its topology may have changed. Deformations do not 
+    change the key, so they do not invalidate it. A memoized key whose 
+    component counts no longer match the shape is computed again, in case 
+    a change upstream of the shape was missed by the callbacks.
+*/
+void PolySymmetryCache::getCacheKeyFromMesh(MDagPath &mesh, PolySymmetryCacheKey &key, ChecksumVersion version)
+{
+    MStatus status;
+
+    MObject shape = mesh.node();
+    MObjectHandle handle(shape);
+
+    auto got = PolySymmetryCache::meshChecksumMemo.find(handle);
+
+    if (got != PolySymmetryCache::meshChecksumMemo.end() && !got->second.keys[version].empty())
+    {
+        const PolySymmetryCacheKey &memoKey = got->second.keys[version];
+        MFnMesh fnMesh(mesh);
+
+        if (memoKey.numberOfVertices == fnMesh.numVertices()
+            && memoKey.numberOfEdges == fnMesh.numEdges()
+            && memoKey.numberOfFaces == fnMesh.numPolygons())
+        {
+            PolySymmetryCache::checksumHits++;
+            key = memoKey;
+            return;
+        }
+    }
+
+    PolySymmetryCache::checksumMisses++;
+    PolySymmetryNode::getCacheKeyFromMesh(mesh, key, version);
+
+    if (key.empty()) { return; }
+
+    if (got == PolySymmetryCache::meshChecksumMemo.end())
+    {
+        MeshChecksumMemo memo;
+
+        MCallbackId topologyCallbackId = MPolyMessage::addPolyTopologyChangedCallback(shape, PolySymmetryCache::meshTopologyChangedCallback, NULL, &status);
+
+        // Without the callbacks a stale key could be returned, so the key is not kept.
+        if (!status) { return; }
+
+        MCallbackId attributeCallbackId = MNodeMessage::addAttributeChangedCallback(shape, PolySymmetryCache::meshAttributeChangedCallback, NULL, &status);
+        
+        if (!status) 
+        { 
+            MMessage::removeCallback(topologyCallbackId);
+            return; 
+        }
+
+        memo.callbackIDs.append(topologyCallbackId);
+        memo.callbackIDs.append(attributeCallbackId);
+
+        got = PolySymmetryCache::meshChecksumMemo.emplace(handle, memo).first;
+    }
+
+    got->second.keys[version] = key;
+}
+
+void PolySymmetryCache::meshTopologyChangedCallback(MObject &node, void* clientData)
+{
+    auto got = PolySymmetryCache::meshChecksumMemo.find(MObjectHandle(node));
+
+    if (got != PolySymmetryCache::meshChecksumMemo.end())
+    {
+        got->second.keys[kVertexRingChecksum] = PolySymmetryCacheKey();
+        got->second.keys[kTopologyChecksum] = PolySymmetryCacheKey();
+    }
+}
+
+/*
+    Connecting, disconnecting or setting the inMesh or outMesh of a shape 
+    can replace its topology without a topology changed message.
+*/
+void PolySymmetryCache::meshAttributeChangedCallback(MNodeMessage::AttributeMessage msg, MPlug &plug, MPlug &otherPlug, void* clientData)
+{
+    int changes = MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken | MNodeMessage::kAttributeSet;
+
+    if ((msg & changes) == 0) { return; }
+
+    MString attributeName = plug.partialName(false, false, false, false, false, true);
+
+    if (attributeName == "inMesh" || attributeName == "outMesh")
+    {
+        MObject node = plug.node();
+        PolySymmetryCache::meshTopologyChangedCallback(node, clientData);
+    }
+}
+
+void PolySymmetryCache::removeChecksumMemo(MObject &shape)
+{
+    auto got = PolySymmetryCache::meshChecksumMemo.find(MObjectHandle(shape));
+
+    if (got == PolySymmetryCache::meshChecksumMemo.end()) { return; }
+
+    MMessage::removeCallbacks(got->second.callbackIDs);
+    PolySymmetryCache::meshChecksumMemo.erase(got);
+}
+
+void PolySymmetryCache::clearChecksumMemo()
+{
+    for (auto &item : PolySymmetryCache::meshChecksumMemo)
+    {
+        MMessage::removeCallbacks(item.second.callbackIDs);
+    }
+
+    PolySymmetryCache::meshChecksumMemo.clear();
+}
+
+
+/*
+    Returns the decoded tables of the node, if a command has already 
+    read them since the node last changed.
+*/
+bool PolySymmetryCache::getTablesFromCache(MObject &node, MObject &tablesData, const PolySymmetryTables* &tables)
+{
+    auto got = PolySymmetryCache::tablesCache.find(MObjectHandle(node));
+
+    if (got == PolySymmetryCache::tablesCache.end()) { return false; }
+
+    tablesData = got->second.tablesData;
+    tables = got->second.tables;
+
+    return true;
+}
+
+void PolySymmetryCache::addTablesToCache(MObject &node, MObject &tablesData, const PolySymmetryTables* tables)
+{
+    CachedSymmetryTables &entry = PolySymmetryCache::tablesCache[MObjectHandle(node)];
+
+    entry.tablesData = tablesData;
+    entry.tables = tables;
+}
+
+void PolySymmetryCache::removeTablesFromCache(MObject &node)
+{
+    PolySymmetryCache::tablesCache.erase(MObjectHandle(node));
 }
\ No newline at end of file
@@ -6,16 +6,49 @@
 #ifndef POLY_SYMMETRY_SCENE_CACHE_H
 #define POLY_SYMMETRY_SCENE_CACHE_H
 
+#include "meshData.h"
+#include "polySymmetryNode.h"
+#include "polySymmetryTables.h"
+
 #include <string>
 #include <unordered_map>
 
 #include <maya/MCallbackIdArray.h>
+#include <maya/MDagPath.h>
+#include <maya/MNodeMessage.h>
 #include <maya/MObject.h>
 #include <maya/MObjectHandle.h>
+#include <maya/MPlug.h>
 #include <maya/MStatus.h>
 
 using namespace std; 
 
+struct MObjectHandleHash
+{
+    size_t operator()(const MObjectHandle &handle) const { return (size_t) handle.hashCode(); }
+};
+
+/*
+    The cache keys of a mesh shape, one per checksum version, kept until the 
+    topology of the shape changes.
+*/
+struct MeshChecksumMemo
+{
+    PolySymmetryCacheKey    keys[2];
+    MCallbackIdArray        callbackIDs;
+};
+
+/*
+    The decoded tables of a polySymmetryData node. tablesData holds a 
+    reference to the data, so the tables stay valid for a command that 
+    borrowed them even after the entry is removed.
+*/
+struct CachedSymmetryTables
+{
+    MObject                     tablesData;
+    const PolySymmetryTables*   tables = nullptr;
+};
+
 class PolySymmetryCache
 {
 public:
@@ -26,20 +59,47 @@ public:
 
     static void         nodeAddedCallback(MObject &node, void* clientData);
     static void         nodeRemovedCallback(MObject &node, void* clientData);
+    static void         meshRemovedCallback(MObject &node, void* clientData);
 
     static void         newFileCallback(void* clientData);
 
     static void         beforeOpenFileCallback(void* clientData);
     static void         afterOpenFileCallback(void* clientData);
 
-    static void         addNodeToCache(MObject &node);
+    static void         meshTopologyChangedCallback(MObject &node, void* clientData);
+    static void         meshAttributeChangedCallback(MNodeMessage::AttributeMessage msg, MPlug &plug, MPlug &otherPlug, void* clientData);
+
+    static bool         addNodeToCache(MObject &node);
     static bool         getNodeFromCache(MDagPath &mesh, MObject &node);
+    static bool         getTablesFromDiskCache(MDagPath &mesh, MObject &tablesData, const PolySymmetryTables* &tables, PolySymmetryCacheKey &key);
+    static bool         getMeshTables(MDagPath &mesh, MObject &tablesData, const PolySymmetryTables* &tables);
+
+    static void         getCacheKeyFromMesh(MDagPath &mesh, PolySymmetryCacheKey &key, ChecksumVersion version);
+    static void         removeChecksumMemo(MObject &shape);
+    static void         clearChecksumMemo();
+
+    static bool         getTablesFromCache(MObject &node, MObject &tablesData, const PolySymmetryTables* &tables);
+    static void         addTablesToCache(MObject &node, MObject &tablesData, const PolySymmetryTables* tables);
+    static void         removeTablesFromCache(MObject &node);
 
 public:
-    static unordered_map<string, MObjectHandle>     symmetryNodeCache;
+    // Several nodes can share a key. Lookups tell them apart with PolySymmetryNode::verifyMesh.
+    static unordered_multimap<PolySymmetryCacheKey, MObjectHandle, PolySymmetryCacheKeyHash>   symmetryNodeCache;
 
     static MCallbackIdArray     callbackIDs;
     static bool                 cacheNodes;
+
+    // Cached nodes whose checksum is a kVertexRingChecksum. While there are 
+    // none, lookups never compute the slow vertex ring checksum.
+    static int                  vertexRingNodes;
+
+    static unordered_map<MObjectHandle, MeshChecksumMemo, MObjectHandleHash>  meshChecksumMemo;
+
+    static unsigned int         checksumHits;
+    static unsigned int         checksumMisses;
+
+    // Decoded tables by node, shared by every command that uses the node.
+    static unordered_map<MObjectHandle, CachedSymmetryTables, MObjectHandleHash>  tablesCache;
 };
 
 #endif
\ No newline at end of file
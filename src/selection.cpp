@@ -132,17 +132,24 @@ bool getSymmetricalComponentSelection(MeshData &meshData, MSelectionList &select
         faceIndices.size() == 2 &&
         (leftSideVertexSelected ? numberOfVerticesSelected == 3 : numberOfVerticesSelected == 2)
     ) {
-        bool edge0NotOnBorder = meshData.edgeData[edgeIndices[0]].connectedFaces.size() > 1;
-        bool edge1NotOnBorder = meshData.edgeData[edgeIndices[1]].connectedFaces.size() > 1;
+        bool edge0NotOnBorder = meshData.edgeFaces.rowSize(edgeIndices[0]) > 1;
+        bool edge1NotOnBorder = meshData.edgeFaces.rowSize(edgeIndices[1]) > 1;
 
-        vector<int> edgesOnFace0 = intersection(meshData.faceData[faceIndices[0]].connectedEdges, edgeIndices);
-        vector<int> edgesOnFace1 = intersection(meshData.faceData[faceIndices[1]].connectedEdges, edgeIndices);
+        vector<int> edgesOnFace0;
+        vector<int> edgesOnFace1;
+        vector<int> verticesOnEdge0;
+        vector<int> verticesOnEdge1;
+        vector<int> verticesOnFace0;
+        vector<int> verticesOnFace1;
 
-        vector<int> verticesOnEdge0 = intersection(meshData.edgeData[edgeIndices[0]].connectedVertices, vertexIndices);
-        vector<int> verticesOnEdge1 = intersection(meshData.edgeData[edgeIndices[1]].connectedVertices, vertexIndices);
+        intersection(meshData.faceEdges[faceIndices[0]], edgeIndices, edgesOnFace0);
+        intersection(meshData.faceEdges[faceIndices[1]], edgeIndices, edgesOnFace1);
 
-        vector<int> verticesOnFace0 = intersection(meshData.faceData[faceIndices[0]].connectedVertices, vertexIndices);
-        vector<int> verticesOnFace1 = intersection(meshData.faceData[faceIndices[1]].connectedVertices, vertexIndices);
+        intersection(meshData.edgeVertices[edgeIndices[0]], vertexIndices, verticesOnEdge0);
+        intersection(meshData.edgeVertices[edgeIndices[1]], vertexIndices, verticesOnEdge1);
+
+        intersection(meshData.faceVertices[faceIndices[0]], vertexIndices, verticesOnFace0);
+        intersection(meshData.faceVertices[faceIndices[1]], vertexIndices, verticesOnFace1);
 
         int leftSideVertex = -1;
 
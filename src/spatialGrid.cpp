@@ -0,0 +1,225 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "spatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+using namespace std;
+
+// Cell coordinates are packed 21 bits per axis into a 64-bit key.
+static const int64_t CELL_COORDINATE_LIMIT = int64_t(1) << 21;
+
+void SpatialGrid::clear()
+{
+    cells.clear();
+    cellTableBits = 0;
+
+    cellPoints.clear();
+    cellPositions.clear();
+}
+
+
+void SpatialGrid::build(const MPointArray &points, double tolerance)
+{
+    vector<int> pointIndices(points.length());
+
+    for (int i = 0; i < (int) pointIndices.size(); i++)
+    {
+        pointIndices[i] = i;
+    }
+
+    this->build(points, pointIndices, tolerance);
+}
+
+
+void SpatialGrid::build(const MPointArray &points, const vector<int> &pointIndices, double tolerance)
+{
+    this->clear();
+
+    int numberOfPoints = (int) pointIndices.size();
+
+    if (numberOfPoints == 0) { return; }
+
+    double minimum[3] = {points[pointIndices[0]].x, points[pointIndices[0]].y, points[pointIndices[0]].z};
+    double maximum[3] = {minimum[0], minimum[1], minimum[2]};
+
+    for (int i : pointIndices)
+    {
+        const MPoint &point = points[i];
+
+        minimum[0] = min(minimum[0], point.x);
+        minimum[1] = min(minimum[1], point.y);
+        minimum[2] = min(minimum[2], point.z);
+
+        maximum[0] = max(maximum[0], point.x);
+        maximum[1] = max(maximum[1], point.y);
+        maximum[2] = max(maximum[2], point.z);
+    }
+
+    // Cells are never so small that the coordinates overflow the key.
+    double largestExtent = max(maximum[0] - minimum[0], max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+
+    cellSize = max(4.0 * tolerance, largestExtent / (double) (CELL_COORDINATE_LIMIT - 4));
+
+    if (cellSize <= 0.0) { cellSize = 1.0; }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        origin[axis] = minimum[axis] - cellSize;
+    }
+
+    while ((1 << cellTableBits) < 2 * numberOfPoints)
+    {
+        cellTableBits++;
+    }
+
+    int numberOfSlots = 1 << cellTableBits;
+
+    cells.resize(numberOfSlots);
+
+    vector<int> pointSlots(numberOfPoints);
+
+    for (int i = 0; i < numberOfPoints; i++)
+    {
+        const MPoint &point = points[pointIndices[i]];
+
+        int64_t cellKey = this->getCellKey(
+            this->getCellCoordinate(point.x, 0),
+            this->getCellCoordinate(point.y, 1),
+            this->getCellCoordinate(point.z, 2)
+        );
+
+        int slot = this->getTableSlot(cellKey);
+
+        cells[slot].key = cellKey;
+        cells[slot].last++;
+
+        pointSlots[i] = slot;
+    }
+
+    int numberOfCellPoints = 0;
+
+    for (Cell &cell : cells)
+    {
+        cell.first = numberOfCellPoints;
+        numberOfCellPoints += cell.last;
+        cell.last = cell.first;
+    }
+
+    cellPoints.resize(numberOfPoints);
+    cellPositions.resize(numberOfPoints);
+
+    for (int i = 0; i < numberOfPoints; i++)
+    {
+        int j = cells[pointSlots[i]].last++;
+
+        cellPoints[j] = pointIndices[i];
+        cellPositions[j] = points[pointIndices[i]];
+    }
+}
+
+
+/*
+    Returns the index of the point closest to position, or -1 if no point is 
+    within the tolerance. Ties go to the lowest point index.
+*/
+int SpatialGrid::findClosestPoint(const MPoint &position, double tolerance) const
+{
+    if (cellPoints.empty()) { return -1; }
+
+    int64_t first[3] = {
+        this->getCellCoordinate(position.x - tolerance, 0),
+        this->getCellCoordinate(position.y - tolerance, 1),
+        this->getCellCoordinate(position.z - tolerance, 2)
+    };
+
+    int64_t last[3] = {
+        this->getCellCoordinate(position.x + tolerance, 0),
+        this->getCellCoordinate(position.y + tolerance, 1),
+        this->getCellCoordinate(position.z + tolerance, 2)
+    };
+
+    int result = -1;
+    double resultDistance = tolerance * tolerance;
+
+    for (int64_t x = first[0]; x <= last[0]; x++)
+    {
+        for (int64_t y = first[1]; y <= last[1]; y++)
+        {
+            for (int64_t z = first[2]; z <= last[2]; z++)
+            {
+                int64_t cellKey = this->getCellKey(x, y, z);
+
+                if (cellKey == -1) { continue; }
+
+                const Cell &cell = cells[this->getTableSlot(cellKey)];
+
+                for (int i = cell.first; i < cell.last; i++)
+                {
+                    double dx = cellPositions[i].x - position.x;
+                    double dy = cellPositions[i].y - position.y;
+                    double dz = cellPositions[i].z - position.z;
+
+                    double distance = dx * dx + dy * dy + dz * dz;
+
+                    if (distance <= resultDistance && (result == -1 || distance < resultDistance || cellPoints[i] < result))
+                    {
+                        result = cellPoints[i];
+                        resultDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+
+int64_t SpatialGrid::getCellKey(int64_t x, int64_t y, int64_t z) const
+{
+    if (x < 0 || y < 0 || z < 0 || x >= CELL_COORDINATE_LIMIT || y >= CELL_COORDINATE_LIMIT || z >= CELL_COORDINATE_LIMIT)
+    {
+        return -1;
+    }
+
+    return (x << 42) | (y << 21) | z;
+}
+
+
+int64_t SpatialGrid::getCellCoordinate(double value, int axis) const
+{
+    double coordinate = floor((value - origin[axis]) / cellSize);
+
+    // Positions far outside the grid map to a cell that is never occupied.
+    if (coordinate < -1.0 || coordinate > (double) CELL_COORDINATE_LIMIT) { return -1; }
+
+    return (int64_t) coordinate;
+}
+
+
+/*
+    Returns the slot of the hash table that holds the cell, or the empty slot 
+    where it would be stored.
+*/
+int SpatialGrid::getTableSlot(int64_t cellKey) const
+{
+    int mask = (1 << cellTableBits) - 1;
+    int slot = (int) (((uint64_t) cellKey * 0x9E3779B97F4A7C15ULL) >> (64 - cellTableBits)) & mask;
+
+    while (cells[slot].key != -1 && cells[slot].key != cellKey)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_SPATIAL_GRID_H
+#define POLY_SYMMETRY_SPATIAL_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+using namespace std;
+
+/*
+    Uniform grid over a set of points, for finding the point closest to a 
+    position within a small tolerance. Occupied cells are stored in an open 
+    addressing hash table on the cell coordinates, and the points in each 
+    cell are stored next to each other, in the order of the table.
+
+    Cells are four times the tolerance wide, so a lookup usually visits one 
+    to four cells, and at most eight.
+*/
+class SpatialGrid
+{
+public:
+    void                clear();
+    void                build(const MPointArray &points, double tolerance);
+    void                build(const MPointArray &points, const vector<int> &pointIndices, double tolerance);
+
+    int                 numberOfPoints() const              { return (int) cellPoints.size(); }
+    int                 findClosestPoint(const MPoint &position, double tolerance) const;
+
+private:
+    int64_t             getCellKey(int64_t x, int64_t y, int64_t z) const;
+    int64_t             getCellCoordinate(double value, int axis) const;
+    int                 getTableSlot(int64_t cellKey) const;
+
+private:
+    double              cellSize = 1.0;
+    double              origin[3] = {0.0, 0.0, 0.0};
+
+    // The key and the range of points of a cell are kept together, so a 
+    // lookup reads one slot of the table for each cell it visits.
+    struct Cell
+    {
+        int64_t         key = -1;
+        int             first = 0;
+        int             last = 0;
+    };
+
+    vector<Cell>        cells;
+    int                 cellTableBits = 0;
+
+    // The points in a cell are cellPoints[cell.first] to cellPoints[cell.last].
+    vector<int>         cellPoints;
+    vector<MPoint>      cellPositions;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#include "threadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <maya/MStatus.h>
+
+using namespace std;
+
+static vector<thread>                               workers;
+
+static mutex                                        poolMutex;
+static condition_variable                           tasksReady;
+static condition_variable                           tasksDone;
+
+static const function<void(int, int)>*              currentTask = nullptr;
+static int                                          currentNumberOfTasks = 0;
+static atomic<int>                                  nextTask(0);
+static int                                          busyWorkers = 0;
+static unsigned                                     generation = 0;
+static bool                                         stopping = false;
+
+// Only one parallelFor runs at a time. A parallelFor called from inside a task runs serially,
+// with the thread index of the task that called it.
+static mutex                                        parallelForMutex;
+static thread_local bool                            insideTask = false;
+static thread_local int                             insideTaskThreadIndex = 0;
+
+static void runTasks(int threadIndex)
+{
+    insideTask = true;
+    insideTaskThreadIndex = threadIndex;
+
+    for (int i = nextTask++; i < currentNumberOfTasks; i = nextTask++)
+    {
+        (*currentTask)(i, threadIndex);
+    }
+
+    insideTask = false;
+}
+
+static void workerLoop(int threadIndex)
+{
+    unsigned lastGeneration = 0;
+
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock(poolMutex);
+            tasksReady.wait(lock, [&] { return stopping || generation != lastGeneration; });
+
+            if (stopping) { return; }
+
+            lastGeneration = generation;
+        }
+
+        runTasks(threadIndex);
+
+        {
+            lock_guard<mutex> lock(poolMutex);
+
+            if (--busyWorkers == 0) 
+            { 
+                tasksDone.notify_one(); 
+            }
+        }
+    }
+}
+
+/*
+    Starts the worker threads. By default there is one thread for each core.
+*/
+MStatus ThreadPool::initialize(int numberOfThreads)
+{
+    if (!workers.empty()) { return MStatus::kSuccess; }
+
+    if (numberOfThreads <= 0)
+    {
+        numberOfThreads = (int) thread::hardware_concurrency();
+    }
+
+    int numberOfWorkers = numberOfThreads - 1;
+
+    stopping = false;
+
+    for (int i = 0; i < numberOfWorkers; i++)
+    {
+        workers.push_back(thread(workerLoop, i + 1));
+    }
+
+    return MStatus::kSuccess;
+}
+
+MStatus ThreadPool::uninitialize()
+{
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopping = true;
+    }
+
+    tasksReady.notify_all();
+
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+
+    return MStatus::kSuccess;
+}
+
+/*
+    Number of threads that run tasks, including the thread that calls parallelFor.
+    Thread indices passed to tasks are less than this.
+*/
+int ThreadPool::numberOfThreads()
+{
+    return (int) workers.size() + 1;
+}
+
+/*
+    Runs task(taskIndex, threadIndex) for every task index and waits for them to finish.
+    The calling thread runs tasks too, with a thread index of 0. Inside a task,
+    the tasks run serially on the calling thread with its own thread index, so
+    per-thread state indexed by threadIndex is never shared between threads.
+*/
+void ThreadPool::parallelFor(int numberOfTasks, const function<void(int taskIndex, int threadIndex)> &task)
+{
+    if (numberOfTasks <= 0) { return; }
+
+    if (workers.empty() || numberOfTasks == 1 || insideTask)
+    {
+        int threadIndex = insideTask ? insideTaskThreadIndex : 0;
+
+        for (int i = 0; i < numberOfTasks; i++)
+        {
+            task(i, threadIndex);
+        }
+
+        return;
+    }
+
+    lock_guard<mutex> parallelForLock(parallelForMutex);
+
+    {
+        lock_guard<mutex> lock(poolMutex);
+
+        currentTask = &task;
+        currentNumberOfTasks = numberOfTasks;
+        nextTask = 0;
+        busyWorkers = (int) workers.size();
+        generation++;
+    }
+
+    tasksReady.notify_all();
+
+    runTasks(0);
+
+    {
+        unique_lock<mutex> lock(poolMutex);
+        tasksDone.wait(lock, [] { return busyWorkers == 0; });
+
+        currentTask = nullptr;
+    }
+}
\ No newline at end of file
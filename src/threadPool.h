@@ -0,0 +1,32 @@
+/**
+    Copyright (c) 2017 Ryan Porter    
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+#ifndef POLY_SYMMETRY_THREAD_POOL_H
+#define POLY_SYMMETRY_THREAD_POOL_H
+
+#include <functional>
+
+#include <maya/MStatus.h>
+
+using namespace std;
+
+/*
+    Worker threads shared by the commands in the plugin. The threads are 
+    started when the plugin is loaded and stopped when it is unloaded.
+
+    Tasks must not call into Maya. 
+*/
+class ThreadPool
+{
+public:
+    static MStatus      initialize(int numberOfThreads=0);
+    static MStatus      uninitialize();
+
+    static int          numberOfThreads();
+
+    static void         parallelFor(int numberOfTasks, const function<void(int taskIndex, int threadIndex)> &task);
+};
+
+#endif
\ No newline at end of file
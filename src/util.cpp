@@ -10,12 +10,11 @@
 
 using namespace std;
 
-vector<int> intersection(vector<int> &a, vector<int> &b)
+int intersection(IndexRange a, IndexRange b, vector<int> &result)
 {
-    vector<int> result(a.size() + b.size());
-    vector<int>::iterator it; 
+    result.resize(min(a.size(), b.size()));
 
-    it = set_intersection(
+    vector<int>::iterator it = set_intersection(
         a.begin(),
         a.end(),
         b.begin(),
@@ -25,10 +24,36 @@ vector<int> intersection(vector<int> &a, vector<int> &b)
 
     result.resize(it - result.begin());
 
-    return result;    
+    return (int) result.size();
 }
 
-bool contains(vector<int> &items, int &value)
+int singleIntersection(IndexRange a, IndexRange b)
+{
+    int result = -1;
+
+    const int* i = a.begin();
+    const int* j = b.begin();
+
+    while (i != a.end() && j != b.end())
+    {
+        if (*i < *j) 
+        {
+            i++;
+        } else if (*j < *i) {
+            j++;
+        } else {
+            if (result != -1) { return -1; }
+
+            result = *i;
+            i++;
+            j++;
+        }
+    }
+
+    return result;
+}
+
+bool contains(IndexRange items, int value)
 {
     return find(items.begin(), items.end(), value) != items.end();
 }
\ No newline at end of file
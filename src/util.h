@@ -11,7 +11,39 @@
 
 using namespace std;
 
-vector<int> intersection(vector<int> &a, vector<int> &b);
-bool        contains(vector<int> &items, int &value);
+/*
+    Read-only view of a contiguous run of component indices, such as one row
+    of an AdjacencyList or the contents of a vector.
+*/
+struct IndexRange
+{
+    const int*  first = nullptr;
+    const int*  last = nullptr;
+
+    IndexRange() {}
+    IndexRange(const int* first, const int* last) : first(first), last(last) {}
+    IndexRange(const vector<int> &items) : first(items.data()), last(items.data() + items.size()) {}
+
+    const int*  begin() const               { return first; }
+    const int*  end() const                 { return last; }
+    int         size() const                { return (int) (last - first); }
+    bool        empty() const               { return first == last; }
+    const int&  operator[](int i) const     { return first[i]; }
+};
+
+/*
+    The sorted ranges a and b are intersected into result, which is reused 
+    between calls so it only allocates when it has to grow. 
+    Returns the number of shared items.
+*/
+int         intersection(IndexRange a, IndexRange b, vector<int> &result);
+
+/*
+    Returns the only item shared by the sorted ranges a and b, 
+    or -1 if they share no items or more than one.
+*/
+int         singleIntersection(IndexRange a, IndexRange b);
+
+bool        contains(IndexRange items, int value);
 
 #endif
\ No newline at end of file
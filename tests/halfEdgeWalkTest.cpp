@@ -0,0 +1,357 @@
+/**
+    Copyright (c) 2017 Ryan Porter
+    You may use, distribute, or modify this code under the terms of the MIT license.
+*/
+
+/*
+    Checks that the half-edge walk, findSymmetricalShells, finds the same
+    symmetry tables as the original face walk, findSymmetricalVertices, on
+    a corpus of symmetrical meshes whose component indices are shuffled.
+
+    The half-edge walk also solves the edges on the seed faces, which the
+    face walk leaves unresolved, so edges are only compared where the face
+    walk found a mirror.
+*/
+
+#include "meshData.h"
+#include "polySymmetry.h"
+#include "selection.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+struct TestPoint
+{
+    int x;
+    int y;
+    int z;
+};
+
+struct TestMesh
+{
+    string              name;
+    vector<TestPoint>   points;
+    vector<vector<int>> faces;
+};
+
+static bool operator<(const TestPoint &a, const TestPoint &b)
+{
+    return tie(a.x, a.y, a.z) < tie(b.x, b.y, b.z);
+}
+
+/*
+    Adds a grid across the YZ plane, with columns -width to width and rows 0 to
+    height. With triangulate, the bottom row is split into mirrored triangles.
+*/
+static void addGrid(TestMesh &mesh, int width, int height, int z, bool triangulate)
+{
+    int first = (int) mesh.points.size();
+    int rowSize = 2 * width + 1;
+
+    for (int y = 0; y <= height; y++)
+    {
+        for (int x = -width; x <= width; x++)
+        {
+            mesh.points.push_back({x, y, z});
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int c = 0; c < 2 * width; c++)
+        {
+            int a = first + y * rowSize + c;
+            int b = a + 1;
+            int d = a + rowSize;
+            int e = d + 1;
+
+            if (triangulate && y == 0)
+            {
+                if (c < width)
+                {
+                    mesh.faces.push_back({a, b, e});
+                    mesh.faces.push_back({a, e, d});
+                } else {
+                    mesh.faces.push_back({a, b, d});
+                    mesh.faces.push_back({b, e, d});
+                }
+            } else {
+                mesh.faces.push_back({a, b, e, d});
+            }
+        }
+    }
+}
+
+/*
+    Adds a fin on the vertical edge at column x of the grid, and a mirrored
+    fin at -x, which makes both edges non-manifold.
+*/
+static void addFins(TestMesh &mesh, int x, int y, int z)
+{
+    map<TestPoint, int> pointIndices;
+
+    for (int i = 0; i < (int) mesh.points.size(); i++)
+    {
+        pointIndices[mesh.points[i]] = i;
+    }
+
+    for (int side : {-1, 1})
+    {
+        int a = pointIndices[{side * x, y, z}];
+        int b = pointIndices[{side * x, y + 1, z}];
+        int c = (int) mesh.points.size();
+        int d = c + 1;
+
+        mesh.points.push_back({side * x, y + 1, z + 1});
+        mesh.points.push_back({side * x, y, z + 1});
+
+        if (side == 1)
+        {
+            mesh.faces.push_back({a, b, c, d});
+        } else {
+            mesh.faces.push_back({b, a, d, c});
+        }
+    }
+}
+
+static TestMesh makeGridMesh(const string &name, int width, int height, int numberOfShells, bool triangulate, bool fins)
+{
+    TestMesh mesh;
+    mesh.name = name;
+
+    for (int s = 0; s < numberOfShells; s++)
+    {
+        addGrid(mesh, width, height, s * 10, triangulate);
+
+        if (fins) { addFins(mesh, 2, height / 2, s * 10); }
+    }
+
+    return mesh;
+}
+
+/*
+    Shuffles the vertex and face indices of the mesh.
+*/
+static void shuffleMesh(TestMesh &mesh, unsigned int seed)
+{
+    mt19937 random(seed);
+
+    vector<int> vertexOrder(mesh.points.size());
+
+    for (int i = 0; i < (int) vertexOrder.size(); i++)
+    {
+        vertexOrder[i] = i;
+    }
+
+    shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+    shuffle(mesh.faces.begin(), mesh.faces.end(), random);
+
+    vector<TestPoint> points(mesh.points.size());
+
+    for (int i = 0; i < (int) vertexOrder.size(); i++)
+    {
+        points[vertexOrder[i]] = mesh.points[i];
+    }
+
+    for (vector<int> &face : mesh.faces)
+    {
+        for (int &v : face)
+        {
+            v = vertexOrder[v];
+        }
+    }
+
+    mesh.points = points;
+}
+
+static void unpackTestMesh(TestMesh &mesh, MeshData &meshData)
+{
+    vector<int> polygonCounts;
+    vector<int> polygonConnects;
+    vector<int> edgeConnects;
+
+    for (vector<int> &face : mesh.faces)
+    {
+        polygonCounts.push_back((int) face.size());
+        polygonConnects.insert(polygonConnects.end(), face.begin(), face.end());
+    }
+
+    int numberOfVertices = (int) mesh.points.size();
+
+    MeshData::getEdgeConnects(numberOfVertices, polygonCounts, polygonConnects, edgeConnects);
+    meshData.unpackTopology(numberOfVertices, polygonCounts, polygonConnects, edgeConnects);
+}
+
+/*
+    Seeds each shell with the edges from (-1, 1) to (-1, 2) and from (1, 1)
+    to (1, 2), on the faces towards the center column.
+*/
+static void getSelections(TestMesh &mesh, MeshData &meshData, int numberOfShells, vector<ComponentSelection> &selections)
+{
+    map<TestPoint, int> pointIndices;
+
+    for (int i = 0; i < (int) mesh.points.size(); i++)
+    {
+        pointIndices[mesh.points[i]] = i;
+    }
+
+    vector<int> sharedFaces;
+
+    for (int s = 0; s < numberOfShells; s++)
+    {
+        int z = s * 10;
+        ComponentSelection selection;
+
+        int vertices[2][3];
+
+        for (int side = 0; side < 2; side++)
+        {
+            int x = side == 0 ? 1 : -1;
+
+            vertices[side][0] = pointIndices[{x, 1, z}];
+            vertices[side][1] = pointIndices[{x, 2, z}];
+            vertices[side][2] = pointIndices[{0, 1, z}];
+        }
+
+        int edges[2];
+        int faces[2];
+
+        for (int side = 0; side < 2; side++)
+        {
+            edges[side] = singleIntersection(meshData.vertexEdges[vertices[side][0]], meshData.vertexEdges[vertices[side][1]]);
+
+            intersection(meshData.vertexFaces[vertices[side][0]], meshData.vertexFaces[vertices[side][1]], sharedFaces);
+
+            faces[side] = -1;
+
+            for (int &f : sharedFaces)
+            {
+                if (contains(meshData.faceVertices[f], vertices[side][2])) { faces[side] = f; }
+            }
+        }
+
+        selection.edgeIndices = pair<int, int>(edges[0], edges[1]);
+        selection.faceIndices = pair<int, int>(faces[0], faces[1]);
+        selection.vertexIndices = pair<int, int>(vertices[0][0], vertices[1][0]);
+        selection.leftVertexIndex = vertices[0][0];
+
+        selections.push_back(selection);
+    }
+}
+
+static int countMismatches(const vector<int> &expected, const vector<int> &result, bool skipUnresolved)
+{
+    int numberOfMismatches = 0;
+
+    for (int i = 0; i < (int) expected.size(); i++)
+    {
+        if (skipUnresolved && expected[i] == -1) { continue; }
+
+        if (expected[i] != result[i]) { numberOfMismatches++; }
+    }
+
+    return numberOfMismatches;
+}
+
+/*
+    Counts the vertices whose mirror is not at their mirrored position.
+*/
+static int countMisplacedVertices(const TestMesh &mesh, const vector<int> &vertexSymmetry)
+{
+    int numberOfMisplaced = 0;
+
+    for (int i = 0; i < (int) mesh.points.size(); i++)
+    {
+        int o = vertexSymmetry[i];
+
+        if (o == -1) { numberOfMisplaced++; continue; }
+
+        const TestPoint &p = mesh.points[i];
+        const TestPoint &q = mesh.points[o];
+
+        if (p.x != -q.x || p.y != q.y || p.z != q.z) { numberOfMisplaced++; }
+    }
+
+    return numberOfMisplaced;
+}
+
+static bool testMesh(TestMesh mesh, int numberOfShells, unsigned int seed)
+{
+    shuffleMesh(mesh, seed);
+
+    MeshData meshData;
+    unpackTestMesh(mesh, meshData);
+
+    vector<ComponentSelection> selections;
+    getSelections(mesh, meshData, numberOfShells, selections);
+
+    PolySymmetryData faceWalk;
+    PolySymmetryData halfEdgeWalk;
+
+    faceWalk.initialize(meshData);
+    halfEdgeWalk.initialize(meshData);
+
+    faceWalk.findSymmetricalShells(selections, true);
+    halfEdgeWalk.findSymmetricalShells(selections);
+
+    int vertexMismatches = countMismatches(faceWalk.vertexSymmetryIndices, halfEdgeWalk.vertexSymmetryIndices, false);
+    int faceMismatches = countMismatches(faceWalk.faceSymmetryIndices, halfEdgeWalk.faceSymmetryIndices, false);
+    int edgeMismatches = countMismatches(faceWalk.edgeSymmetryIndices, halfEdgeWalk.edgeSymmetryIndices, true);
+    int misplacedVertices = countMisplacedVertices(mesh, halfEdgeWalk.vertexSymmetryIndices);
+
+    bool passed = vertexMismatches == 0 && faceMismatches == 0 && edgeMismatches == 0 && misplacedVertices == 0;
+
+    printf(
+        "%s %s (seed %u): %d vertex, %d edge and %d face mismatches, %d misplaced vertices\n",
+        passed ? "PASS" : "FAIL",
+        mesh.name.c_str(),
+        seed,
+        vertexMismatches,
+        edgeMismatches,
+        faceMismatches,
+        misplacedVertices
+    );
+
+    return passed;
+}
+
+int main()
+{
+    struct TestCase
+    {
+        TestMesh    mesh;
+        int         numberOfShells;
+    };
+
+    vector<TestCase> corpus = {
+        {makeGridMesh("quads", 6, 5, 1, false, false), 1},
+        {makeGridMesh("triangles", 6, 5, 1, true, false), 1},
+        {makeGridMesh("shells", 4, 4, 3, false, false), 3},
+        {makeGridMesh("wide", 40, 3, 1, false, false), 1},
+        {makeGridMesh("fins", 6, 5, 1, false, true), 1},
+        {makeGridMesh("fin shells", 5, 6, 2, true, true), 2}
+    };
+
+    int numberOfFailures = 0;
+
+    for (TestCase &testCase : corpus)
+    {
+        for (unsigned int seed = 1; seed <= 4; seed++)
+        {
+            if (!testMesh(testCase.mesh, testCase.numberOfShells, seed))
+            {
+                numberOfFailures++;
+            }
+        }
+    }
+
+    return numberOfFailures == 0 ? 0 : 1;
+}
\ No newline at end of file